@@ -0,0 +1,220 @@
+/* timings for the parts of the game that get slow as the room gets big
+ * construction, seeding at a few densities, select on a room with no mouthbreathers at all (one flood fill over the
+ * whole thing), neighbor iteration and display, each from 5x5 up to --max
+ * then seeding and the flood fill again at the beginner, intermediate and expert layouts, where most games are played
+ *
+ * benchmark [--max N] [--seconds S] [--format csv|json]
+ * results go to stdout, one line per measurement, so runs before and after a change can be diffed or loaded into
+ * whatever draws the graphs
+ */
+
+#include "mouthbreather.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr int DEFAULT_BENCHMARK_SIZE_LIMIT_ = 4096; // SIZE_LIMIT_ would take longer than anyone wants to wait
+constexpr double DEFAULT_SECONDS_ = 0.25;           // how long to keep repeating each measurement
+constexpr float DENSITIES_[] = {0.05f, 0.2f, 0.5f};
+
+struct Standard_Layout {
+    const char* name;
+    int width;
+    int height;
+    int mouthbreathers;
+};
+constexpr Standard_Layout STANDARD_LAYOUTS_[] = {{"9x9", 9, 9, 10}, {"16x16", 16, 16, 40}, {"30x16", 30, 16, 99}};
+
+struct Measurement {
+    std::string name;
+    int size;              // the room is size x size
+    double parameter = 0;  // the density for seed, 0 for everything else
+    std::int64_t iterations = 0;
+    double seconds = 0;    // per iteration
+    std::int64_t bytes = 0; // written per iteration, for render and display
+};
+
+struct Benchmark_Options {
+    int max = DEFAULT_BENCHMARK_SIZE_LIMIT_;
+    double seconds = DEFAULT_SECONDS_;
+    bool json = false;
+};
+
+Benchmark_Options get_options(int number_of_arguments, char** arguments)
+{
+    Benchmark_Options options;
+    for(int i = 1; i + 1 < number_of_arguments; i += 2) {
+        std::string flag = arguments[i];
+        if(flag == "--max")
+            options.max = std::clamp(std::stoi(arguments[i + 1]), SIZE_MININUM_, SIZE_LIMIT_);
+        else if(flag == "--seconds")
+            options.seconds = std::stod(arguments[i + 1]);
+        else if(flag == "--format")
+            options.json = std::string(arguments[i + 1]) == "json";
+        else
+            std::cerr << "ignoring " << flag << std::endl;
+    }
+    return options;
+}
+
+// 5, 20, 80, ... up to max, and max itself
+std::vector<int> sizes_up_to(int max)
+{
+    std::vector<int> sizes;
+    for(int size = SIZE_MININUM_; size < max; size *= 4)
+        sizes.push_back(size);
+    sizes.push_back(max);
+    return sizes;
+}
+
+// run prepare then work until seconds have gone by (at least once), only work is timed
+// prepare is there for things like a fresh grid, which would swamp what's being measured
+Measurement measure(std::string name, int size, double seconds, std::function<void()> prepare,
+                    std::function<void()> work)
+{
+    Measurement result;
+    result.name = name;
+    result.size = size;
+    double timed = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        prepare();
+        Clock::time_point began = Clock::now();
+        work();
+        timed += std::chrono::duration<double>(Clock::now() - began).count();
+        ++result.iterations;
+    } while(std::chrono::duration<double>(Clock::now() - start).count() < seconds);
+    result.seconds = timed / result.iterations;
+    return result;
+}
+
+void print(Measurement& result, bool json, bool first)
+{
+    if(json) {
+        std::printf("%s{\"name\": \"%s\", \"size\": %d, \"parameter\": %g, \"iterations\": %lld, \"seconds\": %.9g, "
+                    "\"bytes\": %lld}",
+                    first ? "[\n  " : ",\n  ", result.name.c_str(), result.size, result.parameter,
+                    (long long)result.iterations, result.seconds, (long long)result.bytes);
+    } else {
+        if(first)
+            std::printf("name,size,parameter,iterations,seconds,bytes\n");
+        std::printf("%s,%d,%g,%lld,%.9g,%lld\n", result.name.c_str(), result.size, result.parameter,
+                    (long long)result.iterations, result.seconds, (long long)result.bytes);
+    }
+    std::fflush(stdout);
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Benchmark_Options options = get_options(argc, argv);
+    bool first = true;
+    auto report = [&](Measurement result) {
+        print(result, options.json, first);
+        first = false;
+    };
+
+    for(int side : sizes_up_to(options.max)) {
+        Coordinates size(side, side);
+        Coordinates middle(side / 2 + 1, side / 2 + 1);
+        std::uint64_t random_seed = 1;
+        std::unique_ptr<Grid> room;
+
+        report(measure("construct", side, options.seconds, [&] { room.reset(); },
+                       [&] { room = std::make_unique<Grid>(size); }));
+
+        for(float density : DENSITIES_) {
+            Measurement seeded = measure("seed", side, options.seconds, [&] { room = std::make_unique<Grid>(size); },
+                                         [&] { room->seed(middle, density, random_seed++); });
+            seeded.parameter = density;
+            report(seeded);
+        }
+
+        // nothing to stop the flood fill, so the first select clears the whole room
+        // seeded around a cell outside the room, otherwise seed's own select would already have cleared it
+        float empty = 0;
+        Coordinates nowhere(0, 0);
+        report(measure(
+            "select_empty", side, options.seconds,
+            [&] {
+                room = std::make_unique<Grid>(size);
+                room->seed(nowhere, empty, random_seed);
+            },
+            [&] { room->select(middle); }));
+
+        room = std::make_unique<Grid>(size);
+        float density = DEFAULT_FREQUENCY_;
+        room->seed(middle, density, random_seed);
+        std::int64_t visited = 0;
+        Measurement neighbors = measure(
+            "for_each_neighbor", side, options.seconds, [] {},
+            [&] {
+                const Bit_Plane& playable = room->planes().playable;
+                const std::vector<std::uint64_t>& words = playable.words();
+                for(std::size_t word = 0; word < words.size(); ++word) {
+                    for(std::uint64_t bits = words[word]; bits; bits &= bits - 1)
+                        room->for_each_neighbor(std::int64_t(word) * 64 + std::countr_zero(bits),
+                                                [&](std::int64_t neighbor) { visited += neighbor; });
+                }
+            });
+        volatile std::int64_t keep = visited; // so the loop can't be optimized away
+        (void)keep;
+        report(neighbors);
+
+        std::string frame;
+        Measurement rendered = measure("render", side, options.seconds, [&] { frame.clear(); },
+                                       [&] { room->render(frame); });
+        rendered.bytes = std::int64_t(frame.size());
+        report(rendered);
+
+        // display() writes straight to stdout, point that at /dev/null while it runs so the results stay readable
+        std::fflush(stdout);
+        int saved = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+        Measurement displayed = measure("display", side, options.seconds, [] {}, [&] { room->display(); });
+        std::fflush(stdout);
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+        displayed.bytes = rendered.bytes;
+        report(displayed);
+    }
+
+    // size is the width for these, the height is in the name
+    for(const Standard_Layout& layout : STANDARD_LAYOUTS_) {
+        Coordinates size(layout.width, layout.height);
+        Coordinates middle(layout.width / 2 + 1, layout.height / 2 + 1);
+        float density = float(layout.mouthbreathers) / float(layout.width * layout.height);
+        std::uint64_t random_seed = 1;
+        std::unique_ptr<Grid> room;
+
+        Measurement seeded = measure(std::string("seed_") + layout.name, layout.width, options.seconds,
+                                     [&] { room = std::make_unique<Grid>(size); },
+                                     [&] { room->seed(middle, density, random_seed++); });
+        seeded.parameter = density;
+        report(seeded);
+
+        float empty = 0;
+        Coordinates nowhere(0, 0);
+        report(measure(
+            std::string("select_empty_") + layout.name, layout.width, options.seconds,
+            [&] {
+                room = std::make_unique<Grid>(size);
+                room->seed(nowhere, empty, random_seed);
+            },
+            [&] { room->select(middle); }));
+    }
+    if(options.json && !first)
+        std::printf("\n]\n");
+    return 0;
+}
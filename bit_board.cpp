@@ -0,0 +1,140 @@
+#include "bit_board.hpp"
+
+using namespace mouthbreather;
+
+// how many bits are set
+std::int64_t mouthbreather::Bit_Plane::count() const
+{
+    std::int64_t total = 0;
+    for(std::uint64_t word : _words)
+        total += std::popcount(word);
+    return total;
+}
+
+// how many bits in [begin, end) are set
+std::int64_t mouthbreather::Bit_Plane::count(std::int64_t begin, std::int64_t end) const
+{
+    if(begin >= end)
+        return 0;
+    std::int64_t first = begin >> 6;
+    std::int64_t last = (end - 1) >> 6;
+    std::uint64_t first_mask = ~std::uint64_t(0) << (begin & 63);
+    std::uint64_t last_mask = ~std::uint64_t(0) >> (63 - ((end - 1) & 63));
+    if(first == last)
+        return std::popcount(_words[first] & first_mask & last_mask);
+    std::int64_t total = std::popcount(_words[first] & first_mask) + std::popcount(_words[last] & last_mask);
+    for(std::int64_t word = first + 1; word < last; ++word)
+        total += std::popcount(_words[word]);
+    return total;
+}
+
+bool mouthbreather::Bit_Plane::none() const
+{
+    for(std::uint64_t word : _words) {
+        if(word)
+            return false;
+    }
+    return true;
+}
+
+mouthbreather::Bit_Plane& mouthbreather::Bit_Plane::operator&=(const Bit_Plane& other)
+{
+    for(std::size_t word = 0; word < _words.size(); ++word)
+        _words[word] &= other._words[word];
+    return *this;
+}
+
+mouthbreather::Bit_Plane& mouthbreather::Bit_Plane::operator|=(const Bit_Plane& other)
+{
+    for(std::size_t word = 0; word < _words.size(); ++word)
+        _words[word] |= other._words[word];
+    return *this;
+}
+
+mouthbreather::Bit_Plane& mouthbreather::Bit_Plane::and_not(const Bit_Plane& other)
+{
+    for(std::size_t word = 0; word < _words.size(); ++word)
+        _words[word] &= ~other._words[word];
+    return *this;
+}
+
+// or in a copy of other moved along by distance bits (bit i lands on i + distance)
+// bits that would fall off either end are dropped
+mouthbreather::Bit_Plane& mouthbreather::Bit_Plane::or_shifted(const Bit_Plane& other, std::int64_t distance)
+{
+    std::int64_t size = std::int64_t(_words.size());
+    std::int64_t words = (distance < 0 ? -distance : distance) >> 6;
+    int bits = (distance < 0 ? -distance : distance) & 63;
+    if(distance >= 0) {
+        for(std::int64_t word = size - 1; word >= words; --word) {
+            std::uint64_t moved = other._words[word - words] << bits;
+            if(bits && word - words - 1 >= 0)
+                moved |= other._words[word - words - 1] >> (64 - bits);
+            _words[word] |= moved;
+        }
+    } else {
+        for(std::int64_t word = 0; word + words < size; ++word) {
+            std::uint64_t moved = other._words[word + words] >> bits;
+            if(bits && word + words + 1 < size)
+                moved |= other._words[word + words + 1] << (64 - bits);
+            _words[word] |= moved;
+        }
+    }
+    return *this;
+}
+
+// how many cells in the rectangle from (x_low, y_low) to (x_high, y_high), inclusive, are set in plane
+std::int64_t mouthbreather::Bit_Board::in_region(const Bit_Plane& plane, int x_low, int y_low, int x_high,
+                                                 int y_high) const
+{
+    std::int64_t total = 0;
+    for(std::int64_t y = y_low; y <= y_high; ++y)
+        total += plane.count(y * stride + x_low, y * stride + x_high + 1);
+    return total;
+}
+
+// every cell touching a set cell of plane, built out of 8 shifted copies of the whole plane
+mouthbreather::Bit_Plane mouthbreather::Bit_Board::surrounding(const Bit_Plane& plane) const
+{
+    Bit_Plane result(std::int64_t(plane.words().size() - 1) * 64);
+    std::int64_t offsets[8] = { -1, stride - 1, stride, stride + 1, 1, 1 - stride, -stride, -1 - stride };
+    for(std::int64_t offset : offsets)
+        result.or_shifted(plane, offset);
+    return result;
+}
+
+// hidden cells that touch a revealed cell
+mouthbreather::Bit_Plane mouthbreather::Bit_Board::frontier() const
+{
+    Bit_Plane open = revealed;
+    open &= playable;
+    Bit_Plane result = surrounding(open);
+    result &= playable;
+    result.and_not(revealed);
+    return result;
+}
+
+// every cell that isn't a mouthbreather has been revealed
+bool mouthbreather::Bit_Board::cleared() const
+{
+    const std::vector<std::uint64_t>& room = playable.words();
+    const std::vector<std::uint64_t>& bad = mouthbreathers.words();
+    const std::vector<std::uint64_t>& open = revealed.words();
+    for(std::size_t word = 0; word < room.size(); ++word) {
+        if(room[word] & ~bad[word] & ~open[word])
+            return false;
+    }
+    return true;
+}
+
+// a mouthbreather has been revealed
+bool mouthbreather::Bit_Board::breathed_on() const
+{
+    const std::vector<std::uint64_t>& bad = mouthbreathers.words();
+    const std::vector<std::uint64_t>& open = revealed.words();
+    for(std::size_t word = 0; word < bad.size(); ++word) {
+        if(bad[word] & open[word])
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace mouthbreather
+{
+// one bit per cell, numbered the same way as the cells in a Grid (y * stride + x)
+class Bit_Plane
+{
+    // one spare word on the end so window() can always read the word after the one it starts in
+    std::vector<std::uint64_t> _words;
+
+public:
+    Bit_Plane(){};
+    Bit_Plane(std::int64_t bits)
+        : _words((bits + 63) / 64 + 1, 0){};
+
+    bool test(std::int64_t index) const { return (_words[index >> 6] >> (index & 63)) & 1; }
+    void set(std::int64_t index) { _words[index >> 6] |= std::uint64_t(1) << (index & 63); }
+    void reset(std::int64_t index) { _words[index >> 6] &= ~(std::uint64_t(1) << (index & 63)); }
+    void flip(std::int64_t index) { _words[index >> 6] ^= std::uint64_t(1) << (index & 63); }
+    // set a bit, false if it was already set
+    bool claim(std::int64_t index)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (index & 63);
+        if(_words[index >> 6] & bit)
+            return false;
+        _words[index >> 6] |= bit;
+        return true;
+    }
+    // same as claim, but safe for more than one thread to call at once
+    bool claim_atomic(std::int64_t index)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (index & 63);
+        std::atomic_ref<std::uint64_t> word(_words[index >> 6]);
+        if(word.load(std::memory_order_relaxed) & bit)
+            return false;
+        return !(word.fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+    // same as reset, but safe for more than one thread to call at once
+    void reset_atomic(std::int64_t index)
+    {
+        std::uint64_t bit = std::uint64_t(1) << (index & 63);
+        std::atomic_ref<std::uint64_t> word(_words[index >> 6]);
+        if(word.load(std::memory_order_relaxed) & bit)
+            word.fetch_and(~bit, std::memory_order_relaxed);
+    }
+    // the 64 bits starting at index, lowest bit first
+    std::uint64_t window(std::int64_t index) const
+    {
+        std::int64_t word = index >> 6;
+        int shift = index & 63;
+        if(shift == 0)
+            return _words[word];
+        return (_words[word] >> shift) | (_words[word + 1] << (64 - shift));
+    }
+
+    // how many bits are set, all of them or just the ones in [begin, end)
+    std::int64_t count() const;
+    std::int64_t count(std::int64_t begin, std::int64_t end) const;
+    bool none() const;
+
+    // whole plane at a time, 64 cells per operation
+    Bit_Plane& operator&=(const Bit_Plane& other);
+    Bit_Plane& operator|=(const Bit_Plane& other);
+    Bit_Plane& and_not(const Bit_Plane& other);
+    // or in a copy of other moved along by distance bits (bit i lands on i + distance)
+    Bit_Plane& or_shifted(const Bit_Plane& other, std::int64_t distance);
+
+    std::vector<std::uint64_t>& words() { return _words; }
+    const std::vector<std::uint64_t>& words() const { return _words; }
+};
+
+// everything about a room that's a yes or no per cell, kept as bit planes so questions about a lot of cells at once
+// are answered 64 cells at a time with popcount instead of one Cell at a time
+struct Bit_Board {
+    Bit_Plane mouthbreathers;
+    Bit_Plane revealed; // the index row/column and the border count as revealed, they're never played
+    Bit_Plane flagged;
+    Bit_Plane playable; // every cell that's actually part of the room
+    std::int64_t stride = 0;
+
+    Bit_Board(){};
+    Bit_Board(std::int64_t cells, std::int64_t row_length)
+        : mouthbreathers(cells)
+        , revealed(cells)
+        , flagged(cells)
+        , playable(cells)
+        , stride(row_length){};
+
+    // how many of the 8 cells around index are set in plane, three rows of three bits each
+    std::int64_t around(const Bit_Plane& plane, std::int64_t index) const
+    {
+        return std::popcount(plane.window(index - stride - 1) & 7) + std::popcount(plane.window(index - 1) & 5) +
+               std::popcount(plane.window(index + stride - 1) & 7);
+    }
+    // how many cells in the rectangle from (x_low, y_low) to (x_high, y_high), inclusive, are set in plane
+    std::int64_t in_region(const Bit_Plane& plane, int x_low, int y_low, int x_high, int y_high) const;
+    // every cell touching a set cell of plane, not counting the set cell itself unless it touches another
+    Bit_Plane surrounding(const Bit_Plane& plane) const;
+    // hidden cells that touch a revealed cell, where all the information is
+    Bit_Plane frontier() const;
+    // every cell that isn't a mouthbreather has been revealed
+    bool cleared() const;
+    // a mouthbreather has been revealed, the game's been lost
+    bool breathed_on() const;
+};
+} // namespace mouthbreather
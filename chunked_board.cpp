@@ -0,0 +1,295 @@
+#include "chunked_board.hpp"
+#include "renderer.hpp"
+#include <charconv>
+#include <numeric>
+
+using namespace mouthbreather;
+
+namespace
+{
+constexpr std::int64_t CHUNK_CELLS_ = CHUNK_SIZE_ * CHUNK_SIZE_;
+constexpr std::int64_t CHUNK_MASK_ = CHUNK_SIZE_ - 1;
+
+bool test(const std::uint64_t* plane, std::int64_t local_x, std::int64_t local_y)
+{
+    return (plane[local_y] >> local_x) & 1;
+}
+} // namespace
+
+// the chunk at that chunk position, with its mouthbreathers placed if it's new
+// the same number of them in every chunk, picked with a partial Fisher-Yates over the chunk's cells
+Chunk& mouthbreather::Chunked_Board::chunk(std::int64_t chunk_x, std::int64_t chunk_y)
+{
+    std::uint64_t position = key(chunk_x, chunk_y);
+    if(_cached && _cached_key == position)
+        return *_cached;
+    std::unique_ptr<Chunk>& slot = _chunks[position];
+    if(!slot) {
+        slot = std::make_unique<Chunk>();
+        Random_Generator random(_random_seed ^ (position * 0x9e3779b97f4a7c15));
+        std::int64_t count = std::clamp<std::int64_t>(llround(double(CHUNK_CELLS_) * _frequency), 0, CHUNK_CELLS_);
+        std::uint16_t cells[CHUNK_CELLS_];
+        std::iota(cells, cells + CHUNK_CELLS_, 0);
+        for(std::int64_t i = 0; i < count; ++i) {
+            std::swap(cells[i], cells[i + std::int64_t(random.below(CHUNK_CELLS_ - i))]);
+            slot->mouthbreathers[cells[i] >> CHUNK_BITS_] |= std::uint64_t(1) << (cells[i] & CHUNK_MASK_);
+        }
+        // the first select is always safe
+        for(std::int64_t y = _start_y - 1; y <= _start_y + 1; ++y) {
+            for(std::int64_t x = _start_x - 1; x <= _start_x + 1; ++x) {
+                if((x >> CHUNK_BITS_) == chunk_x && (y >> CHUNK_BITS_) == chunk_y)
+                    slot->mouthbreathers[y & CHUNK_MASK_] &= ~(std::uint64_t(1) << (x & CHUNK_MASK_));
+            }
+        }
+    }
+    _cached_key = position;
+    _cached = slot.get();
+    return *slot;
+}
+
+Chunk* mouthbreather::Chunked_Board::find(std::int64_t chunk_x, std::int64_t chunk_y) const
+{
+    auto found = _chunks.find(key(chunk_x, chunk_y));
+    return found == _chunks.end() ? nullptr : found->second.get();
+}
+
+// the chunk with the cell at (x, y), with its neighbor counts made if they haven't been
+Chunk& mouthbreather::Chunked_Board::counted(std::int64_t x, std::int64_t y)
+{
+    std::int64_t chunk_x = x >> CHUNK_BITS_;
+    std::int64_t chunk_y = y >> CHUNK_BITS_;
+    Chunk& tile = chunk(chunk_x, chunk_y);
+    if(!tile.counts)
+        count(tile, chunk_x, chunk_y);
+    return tile;
+}
+
+// the same three rows of three bits as Bit_Board::around, with the rows of the chunks around this one supplying
+// the cells past its edges
+void mouthbreather::Chunked_Board::count(Chunk& tile, std::int64_t chunk_x, std::int64_t chunk_y)
+{
+    const std::uint64_t* planes[3][3]; // [row][column] of chunks, row 0 is below
+    for(int row = 0; row < 3; ++row) {
+        for(int column = 0; column < 3; ++column)
+            planes[row][column] = chunk(chunk_x + column - 1, chunk_y + row - 1).mouthbreathers;
+    }
+    // rows y - 1 to y + 1 of the whole room, 66 bits wide with the cell left of the chunk in bit 0
+    auto wide_row = [&](std::int64_t y) {
+        int row = y < 0 ? 0 : y >= CHUNK_SIZE_ ? 2 : 1;
+        std::int64_t local = y & CHUNK_MASK_;
+        unsigned __int128 wide = (unsigned __int128)planes[row][1][local] << 1;
+        wide |= planes[row][0][local] >> (CHUNK_SIZE_ - 1);
+        wide |= (unsigned __int128)(planes[row][2][local] & 1) << (CHUNK_SIZE_ + 1);
+        return wide;
+    };
+    tile.counts = std::make_unique<std::uint8_t[]>(CHUNK_CELLS_);
+    for(std::int64_t y = 0; y < CHUNK_SIZE_; ++y) {
+        unsigned __int128 below = wide_row(y - 1);
+        unsigned __int128 middle = wide_row(y);
+        unsigned __int128 above = wide_row(y + 1);
+        for(std::int64_t x = 0; x < CHUNK_SIZE_; ++x) {
+            tile.counts[y * CHUNK_SIZE_ + x] =
+                std::uint8_t(std::popcount(std::uint64_t(below >> x) & 7) +
+                             std::popcount(std::uint64_t(middle >> x) & 5) + std::popcount(std::uint64_t(above >> x) & 7));
+        }
+    }
+    ++_counted_chunks;
+    // the neighbors were the last ones looked up, chunks don't move when the map grows so tile is still good
+    _cached = &tile;
+    _cached_key = key(chunk_x, chunk_y);
+}
+
+void mouthbreather::Chunked_Board::reveal(Chunk& tile, std::int64_t x, std::int64_t y)
+{
+    tile.revealed[y & CHUNK_MASK_] |= std::uint64_t(1) << (x & CHUNK_MASK_);
+    tile.flagged[y & CHUNK_MASK_] &= ~(std::uint64_t(1) << (x & CHUNK_MASK_));
+    ++_revealed;
+}
+
+// false if there's a mouthbreather there
+// the flood fill is the same as Grid::auto_clear, it just asks for the chunk each neighbor is in
+// it stops FLOOD_RADIUS_ away, when mouthbreathers are rare enough the empty cells join up forever, the cells past
+// the edge are next to an empty one so they're safe to select and carry on from
+bool mouthbreather::Chunked_Board::select(std::int64_t x, std::int64_t y)
+{
+    if(!in_range(x, y))
+        return true;
+    if(!_started) {
+        _started = true;
+        _start_x = x;
+        _start_y = y;
+    }
+    Chunk& tile = counted(x, y);
+    if(test(tile.revealed, x & CHUNK_MASK_, y & CHUNK_MASK_))
+        return true;
+    reveal(tile, x, y);
+    if(test(tile.mouthbreathers, x & CHUNK_MASK_, y & CHUNK_MASK_))
+        return false;
+    if(tile.counts[(y & CHUNK_MASK_) * CHUNK_SIZE_ + (x & CHUNK_MASK_)] != 0)
+        return true;
+
+    _frontier.clear();
+    _frontier.emplace_back(x, y);
+    while(!_frontier.empty()) {
+        auto [current_x, current_y] = _frontier.back();
+        _frontier.pop_back();
+        for(std::int64_t neighbor_y = current_y - 1; neighbor_y <= current_y + 1; ++neighbor_y) {
+            for(std::int64_t neighbor_x = current_x - 1; neighbor_x <= current_x + 1; ++neighbor_x) {
+                if(std::max(std::abs(neighbor_x - x), std::abs(neighbor_y - y)) > FLOOD_RADIUS_)
+                    continue;
+                Chunk& around = counted(neighbor_x, neighbor_y);
+                std::int64_t local_x = neighbor_x & CHUNK_MASK_;
+                std::int64_t local_y = neighbor_y & CHUNK_MASK_;
+                if(test(around.revealed, local_x, local_y))
+                    continue;
+                reveal(around, neighbor_x, neighbor_y);
+                if(around.counts[local_y * CHUNK_SIZE_ + local_x] == 0)
+                    _frontier.emplace_back(neighbor_x, neighbor_y);
+            }
+        }
+    }
+    return true;
+}
+
+// mark or unmark a hidden cell as a mouthbreather
+bool mouthbreather::Chunked_Board::flag(std::int64_t x, std::int64_t y)
+{
+    if(!_started || !in_range(x, y))
+        return false;
+    Chunk& tile = chunk(x >> CHUNK_BITS_, y >> CHUNK_BITS_);
+    if(!test(tile.revealed, x & CHUNK_MASK_, y & CHUNK_MASK_))
+        tile.flagged[y & CHUNK_MASK_] ^= std::uint64_t(1) << (x & CHUNK_MASK_);
+    return true;
+}
+
+int mouthbreather::Chunked_Board::number_at(std::int64_t x, std::int64_t y) const
+{
+    const Chunk* tile = find(x >> CHUNK_BITS_, y >> CHUNK_BITS_);
+    if(!tile || !tile->counts || !test(tile->revealed, x & CHUNK_MASK_, y & CHUNK_MASK_) ||
+       test(tile->mouthbreathers, x & CHUNK_MASK_, y & CHUNK_MASK_))
+        return -1;
+    return tile->counts[(y & CHUNK_MASK_) * CHUNK_SIZE_ + (x & CHUNK_MASK_)];
+}
+
+bool mouthbreather::Chunked_Board::revealed(std::int64_t x, std::int64_t y) const
+{
+    const Chunk* tile = find(x >> CHUNK_BITS_, y >> CHUNK_BITS_);
+    return tile && test(tile->revealed, x & CHUNK_MASK_, y & CHUNK_MASK_);
+}
+
+bool mouthbreather::Chunked_Board::flagged(std::int64_t x, std::int64_t y) const
+{
+    const Chunk* tile = find(x >> CHUNK_BITS_, y >> CHUNK_BITS_);
+    return tile && test(tile->flagged, x & CHUNK_MASK_, y & CHUNK_MASK_);
+}
+
+// add a window of the room to the end of frame, top row first, with its own index column and row
+void mouthbreather::Chunked_Board::render(std::string& frame, std::int64_t left, std::int64_t bottom, int columns,
+                                          int rows) const
+{
+    // wide enough for every label in the window, and the mouthbreather symbol
+    int width = int(std::string_view(MOUTHBREATHER_CELL_SYMBOL_).size());
+    for(std::int64_t label : { left, left + columns - 1, bottom, bottom + rows - 1 })
+        width = std::max(width, int(std::to_string(label).size()));
+    auto centered = [&](std::string_view text) {
+        std::size_t padding = std::size_t(width) - text.size();
+        frame.append((padding + 1) / 2, ' ');
+        frame += text;
+        frame.append(padding / 2, ' ');
+    };
+    auto right_aligned = [&](std::string_view text) {
+        frame.append(std::size_t(width) - text.size(), ' ');
+        frame += text;
+        frame += '|';
+    };
+
+    for(std::int64_t y = bottom + rows - 1; y >= bottom; --y) {
+        right_aligned(std::to_string(y));
+        for(std::int64_t x = left; x < left + columns; ++x) {
+            const Chunk* tile = find(x >> CHUNK_BITS_, y >> CHUNK_BITS_);
+            std::int64_t local_x = x & CHUNK_MASK_;
+            std::int64_t local_y = y & CHUNK_MASK_;
+            if(!tile || (!test(tile->revealed, local_x, local_y) && !test(tile->flagged, local_x, local_y)))
+                centered(UNKNOWN_CELL_SYMBOL_);
+            else if(!test(tile->revealed, local_x, local_y))
+                centered(WARNING_CELL_SYMBOL_);
+            else if(test(tile->mouthbreathers, local_x, local_y))
+                centered(MOUTHBREATHER_CELL_SYMBOL_);
+            else if(int number = tile->counts[local_y * CHUNK_SIZE_ + local_x])
+                centered(std::string(1, char('0' + number)));
+            else
+                centered("");
+            frame += '|';
+        }
+        frame += '\n';
+    }
+    right_aligned("");
+    for(std::int64_t x = left; x < left + columns; ++x)
+        right_aligned(std::to_string(x));
+    frame += '\n';
+}
+
+// roughly how much memory the chunks take
+std::int64_t mouthbreather::Chunked_Board::bytes_used() const
+{
+    std::int64_t per_chunk = std::int64_t(sizeof(Chunk) + sizeof(std::unique_ptr<Chunk>) + sizeof(std::uint64_t));
+    return chunks() * per_chunk + _counted_chunks * CHUNK_CELLS_;
+}
+
+// play at the terminal until a mouthbreather is found or the player quits
+// moves are one line each, s x y or f x y with x and y plain numbers, since there's no last row to count letters from
+void mouthbreather::play_unbounded(Game_Parameters& parameters)
+{
+    Chunked_Board board(parameters.frequency, parameters.seed);
+    Coordinates terminal = terminal_size();
+    int columns = terminal.x > 0 ? std::max(terminal.x / 4 - 2, 5) : 20;
+    int rows = terminal.y > 0 ? std::max(terminal.y - 5, 5) : 20;
+    std::int64_t focus_x = 0;
+    std::int64_t focus_y = 0;
+    std::string frame;
+    std::string line;
+    bool alive = true;
+
+    while(alive) {
+        frame.clear();
+        board.render(frame, focus_x - columns / 2, focus_y - rows / 2, columns, rows);
+        std::cout << frame << "flag (f x y), select (s x y) or quit (q)? " << std::flush;
+        if(!std::getline(std::cin, line) || line.starts_with('q'))
+            break;
+        // from_chars instead of stoi, a typo isn't worth an exception
+        const char* at = line.data() + 1;
+        const char* end = line.data() + line.size();
+        std::int64_t x = 0;
+        std::int64_t y = 0;
+        while(at < end && *at == ' ')
+            ++at;
+        std::from_chars_result parsed = std::from_chars(at, end, x);
+        at = parsed.ptr;
+        while(at < end && *at == ' ')
+            ++at;
+        std::from_chars_result parsed_y = std::from_chars(at, end, y);
+        if(line.empty() || (line[0] != 's' && line[0] != 'f') || parsed.ec != std::errc() ||
+           parsed_y.ec != std::errc()) {
+            std::cout << "invalid choice, try again" << std::endl;
+            continue;
+        }
+        if(!Chunked_Board::in_range(x, y)) {
+            std::cout << "that's more than " << UNBOUNDED_LIMIT_ << " cells out, try again" << std::endl;
+            continue;
+        }
+        focus_x = x;
+        focus_y = y;
+        if(line[0] == 'f') {
+            if(!board.flag(x, y))
+                std::cout << "select somewhere first, the room isn't there until you do" << std::endl;
+        } else
+            alive = board.select(x, y);
+    }
+    if(!alive) {
+        frame.clear();
+        board.render(frame, focus_x - columns / 2, focus_y - rows / 2, columns, rows);
+        std::cout << frame << "their wicked breath haunts you" << std::endl;
+    }
+    std::cout << board.cells_revealed() << " cells cleared, " << board.chunks() << " chunks made ("
+              << board.bytes_used() << " bytes)" << std::endl;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "mouthbreather.hpp"
+
+namespace mouthbreather
+{
+constexpr int CHUNK_BITS_ = 6;
+constexpr std::int64_t CHUNK_SIZE_ = std::int64_t(1) << CHUNK_BITS_; // a chunk is CHUNK_SIZE_ x CHUNK_SIZE_ cells
+constexpr std::int64_t FLOOD_RADIUS_ = 4 * CHUNK_SIZE_; // how far one select can clear in a room with no edges
+// how far from 0 a cell can be in either direction, chunk positions are kept in 32 bits each and this leaves room
+// for a flood fill and the chunks around it to go past it without wrapping around onto some other chunk
+constexpr std::int64_t UNBOUNDED_LIMIT_ = std::int64_t(1) << 36;
+
+// one tile of a Chunked_Board, a bit per cell for each plane, row y is one word with column x in bit x
+struct Chunk {
+    std::uint64_t mouthbreathers[CHUNK_SIZE_] = {};
+    std::uint64_t revealed[CHUNK_SIZE_] = {};
+    std::uint64_t flagged[CHUNK_SIZE_] = {};
+    // how many mouthbreathers touch each cell, row-major, only made once something in the chunk is revealed
+    std::unique_ptr<std::uint8_t[]> counts;
+};
+
+/* a room with no edges
+ * it's split into CHUNK_SIZE_ square chunks that are only made when something touches them, each one filled from
+ * its own seed (the room's seed mixed with where the chunk is) so the same room always comes out the same no matter
+ * what order it's explored in, and kept in a hash map by position
+ * a chunk's neighbor counts need the mouthbreathers of the 8 chunks around it, so those get their mouthbreathers
+ * placed too, but nothing else, and memory and time go with how much of the room has been explored, not its size
+ * x grows to the right and y grows up, both can be negative
+ */
+class Chunked_Board
+{
+    float _frequency;
+    std::uint64_t _random_seed;
+    bool _started = false;
+    std::int64_t _start_x = 0; // the first select, nothing is placed around it
+    std::int64_t _start_y = 0;
+    std::unordered_map<std::uint64_t, std::unique_ptr<Chunk>> _chunks;
+    std::int64_t _counted_chunks = 0;
+    std::int64_t _revealed = 0;
+    // flood fill work queue, kept between selects like Grid's
+    std::vector<std::pair<std::int64_t, std::int64_t>> _frontier;
+    // the last chunk looked up, most lookups during a flood fill land in the same one
+    std::uint64_t _cached_key = 0;
+    Chunk* _cached = nullptr;
+
+    static std::uint64_t key(std::int64_t chunk_x, std::int64_t chunk_y)
+    {
+        return (std::uint64_t(std::uint32_t(chunk_x)) << 32) | std::uint32_t(chunk_y);
+    }
+    // the chunk at that chunk position, with its mouthbreathers placed if it's new
+    Chunk& chunk(std::int64_t chunk_x, std::int64_t chunk_y);
+    // null if that chunk hasn't been made yet
+    Chunk* find(std::int64_t chunk_x, std::int64_t chunk_y) const;
+    // the chunk with the cell at (x, y), with its neighbor counts made if they haven't been
+    Chunk& counted(std::int64_t x, std::int64_t y);
+    void count(Chunk& tile, std::int64_t chunk_x, std::int64_t chunk_y);
+    void reveal(Chunk& tile, std::int64_t x, std::int64_t y);
+
+public:
+    Chunked_Board(float frequency, std::uint64_t random_seed)
+        : _frequency(frequency)
+        , _random_seed(random_seed){};
+
+    // false if there's a mouthbreather there, the first select is always safe and clears the cells around it
+    // clears at most FLOOD_RADIUS_ cells away in any direction, does nothing outside in_range()
+    bool select(std::int64_t x, std::int64_t y);
+    // mark or unmark a hidden cell as a mouthbreather, false if it can't be because nothing's been selected yet or
+    // it's outside in_range()
+    // chunks are only made once the first select says where nothing can go, so a flag before it would make one
+    // without that
+    bool flag(std::int64_t x, std::int64_t y);
+    static bool in_range(std::int64_t x, std::int64_t y)
+    {
+        return std::abs(x) <= UNBOUNDED_LIMIT_ && std::abs(y) <= UNBOUNDED_LIMIT_;
+    }
+    // the number showing on a revealed cell, -1 if it's hidden or a mouthbreather
+    int number_at(std::int64_t x, std::int64_t y) const;
+    bool revealed(std::int64_t x, std::int64_t y) const;
+    bool flagged(std::int64_t x, std::int64_t y) const;
+
+    // add the columns x rows window with its bottom left cell at (left, bottom) to the end of frame, with index
+    // labels like Grid::render, chunks nobody has touched are drawn as hidden without being made
+    void render(std::string& frame, std::int64_t left, std::int64_t bottom, int columns, int rows) const;
+
+    std::int64_t chunks() const { return std::int64_t(_chunks.size()); }
+    std::int64_t cells_revealed() const { return _revealed; }
+    // roughly how much memory the chunks take
+    std::int64_t bytes_used() const;
+};
+
+// play on a Chunked_Board at the terminal until a mouthbreather is found or the player quits
+void play_unbounded(Game_Parameters& parameters);
+} // namespace mouthbreather
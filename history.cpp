@@ -0,0 +1,144 @@
+#include "history.hpp"
+#include "journal.hpp"
+
+using namespace mouthbreather;
+
+void mouthbreather::Move_History::reset(const Bit_Board& planes, std::int64_t cells_selected)
+{
+    _changes.clear();
+    _first.assign(1, 0);
+    _selected.assign(1, cells_selected);
+    _checkpoints.clear();
+    _current = 0;
+    _flagged = planes.flagged;
+    _checkpoint_cells = 2 * std::int64_t(planes.revealed.words().size());
+}
+
+// a select only ever reveals cells that were hidden, so all it can't say about how they were before is whether they
+// had a flag, which _flagged remembers, and a flag only ever flips the one bit
+// a checkpoint gets taken once walking the moves since the last one would cost as much as restoring one
+void mouthbreather::Move_History::record(bool flag, std::span<const std::int64_t> changed, const Cell* contents,
+                                         std::int64_t selected_before, std::int64_t selected_after,
+                                         const Bit_Board& planes)
+{
+    if(_current < moves()) { // a new move, what was undone can't be redone anymore
+        _changes.resize(std::size_t(_first[_current]));
+        _first.resize(std::size_t(_current) + 1);
+        _selected.resize(std::size_t(_current) + 1);
+        while(!_checkpoints.empty() && _checkpoints.back().move > _current)
+            _checkpoints.pop_back();
+    }
+    _selected[_current] = selected_before; // seeding can have selected some after reset()
+    for(std::int64_t index : changed) {
+        std::uint8_t after = contents[index].bits;
+        std::uint8_t before = flag ? std::uint8_t(after ^ Cell::FLAGGED)
+                                   : std::uint8_t((after & ~Cell::REVEALED) | (_flagged.test(index) ? Cell::FLAGGED : 0));
+        _changes.push_back(Change{ index, before, after });
+        set_flag(index, after);
+    }
+    _first.push_back(std::int64_t(_changes.size()));
+    _selected.push_back(selected_after);
+    ++_current;
+    if(distance(_checkpoints.empty() ? 0 : _checkpoints.back().move, _current) >= _checkpoint_cells)
+        _checkpoints.push_back(Checkpoint{ _current, planes.revealed.words(), planes.flagged.words() });
+}
+
+// the checkpoints either side of move are the only ones worth looking at, the rest are further away still
+const Move_History::Checkpoint* mouthbreather::Move_History::shortcut(std::int64_t move) const
+{
+    auto after = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), move,
+                                  [](std::int64_t target, const Checkpoint& checkpoint) { return target < checkpoint.move; });
+    const Checkpoint* best = nullptr;
+    std::int64_t cost = distance(_current, move);
+    auto consider = [&](const Checkpoint& checkpoint) {
+        std::int64_t through = _checkpoint_cells + distance(checkpoint.move, move);
+        if(through < cost) {
+            cost = through;
+            best = &checkpoint;
+        }
+    };
+    if(after != _checkpoints.begin())
+        consider(*(after - 1));
+    if(after != _checkpoints.end())
+        consider(*after);
+    return best;
+}
+
+void mouthbreather::Move_History::restored(const Checkpoint& checkpoint)
+{
+    _current = checkpoint.move;
+    _flagged.words() = checkpoint.flagged;
+}
+
+void mouthbreather::Grid::set_history(Move_History* history)
+{
+    _history = history;
+    if(_history)
+        _history->reset(_planes, total_cells_selected);
+}
+
+std::int64_t mouthbreather::Grid::undo(std::int64_t moves)
+{
+    if(!_history)
+        return 0;
+    std::int64_t undone = std::clamp<std::int64_t>(moves, 0, _history->current());
+    if(undone > 0) {
+        if(_journal)
+            _journal->record_undo(undone);
+        return_to(_history->current() - undone);
+    }
+    return undone;
+}
+
+std::int64_t mouthbreather::Grid::redo(std::int64_t moves)
+{
+    if(!_history)
+        return 0;
+    std::int64_t redone = std::clamp<std::int64_t>(moves, 0, _history->moves() - _history->current());
+    if(redone > 0) {
+        if(_journal)
+            _journal->record_redo(redone);
+        return_to(_history->current() + redone);
+    }
+    return redone;
+}
+
+// from a checkpoint only the cells that differ from it get touched, found 64 at a time, then the moves from there
+// are walked one by one, every cell either way goes on the change list so whatever draws the room catches up
+void mouthbreather::Grid::return_to(std::int64_t move)
+{
+    const Move_History::Checkpoint* checkpoint = _history->shortcut(move);
+    if(checkpoint) {
+        std::vector<std::uint64_t>& revealed = _planes.revealed.words();
+        std::vector<std::uint64_t>& flagged = _planes.flagged.words();
+        for(std::size_t word = 0; word < revealed.size(); ++word) {
+            std::uint64_t differ = (revealed[word] ^ checkpoint->revealed[word]) |
+                                   (flagged[word] ^ checkpoint->flagged[word]);
+            revealed[word] = checkpoint->revealed[word];
+            flagged[word] = checkpoint->flagged[word];
+            for(; differ; differ &= differ - 1) {
+                std::int64_t index = std::int64_t(word) * 64 + std::countr_zero(differ);
+                std::uint8_t bits = _contents[index].bits & ~(Cell::REVEALED | Cell::FLAGGED);
+                bits |= _planes.revealed.test(index) ? Cell::REVEALED : 0;
+                bits |= _planes.flagged.test(index) ? Cell::FLAGGED : 0;
+                _contents[index].bits = bits;
+                _changes.push_back(index);
+            }
+        }
+        _history->restored(*checkpoint);
+    }
+    _history->walk(move, [&](std::int64_t index, std::uint8_t bits) {
+        _contents[index].bits = bits;
+        if(bits & Cell::REVEALED)
+            _planes.revealed.set(index);
+        else
+            _planes.revealed.reset(index);
+        if(bits & Cell::FLAGGED)
+            _planes.flagged.set(index);
+        else
+            _planes.flagged.reset(index);
+        _changes.push_back(index);
+    });
+    total_cells_selected = _history->cells_selected();
+    _last_revealed = 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "mouthbreather.hpp"
+
+namespace mouthbreather
+{
+/* every select and flag made on a Grid since set_history(), so they can be taken back and put back again
+ * each move keeps only the cells it changed, with their bits from before and after it, so undoing or redoing one
+ * costs what the move itself changed and never a copy of the room
+ * every so often the revealed and flagged planes get copied as a checkpoint, so going back (or forward) a long way
+ * can start from the nearest one instead of walking every move in between
+ * a new move after an undo throws away whatever could have been redone
+ */
+class Move_History
+{
+public:
+    struct Change {
+        std::int64_t index;
+        std::uint8_t before;
+        std::uint8_t after;
+    };
+    // the revealed and flagged planes as they were after move number move
+    struct Checkpoint {
+        std::int64_t move;
+        std::vector<std::uint64_t> revealed;
+        std::vector<std::uint64_t> flagged;
+    };
+
+private:
+    std::vector<Change> _changes;         // every move's cells, oldest move first
+    std::vector<std::int64_t> _first;     // where each move starts in _changes, plus one past the last
+    std::vector<std::int64_t> _selected;  // number_selected() before the first move and after each one
+    std::vector<Checkpoint> _checkpoints; // oldest first
+    std::int64_t _current = 0;            // moves that are in effect, the ones after it can be redone
+    std::int64_t _checkpoint_cells = 0;   // what restoring a checkpoint costs, in cells walked
+    // the flags as of _current, a select takes flags off the cells it reveals and this is how it's known which
+    // of them had one
+    Bit_Plane _flagged;
+
+    // how many cells walking between two moves touches
+    std::int64_t distance(std::int64_t from, std::int64_t to) const
+    {
+        return from < to ? _first[to] - _first[from] : _first[from] - _first[to];
+    }
+    void set_flag(std::int64_t index, std::uint8_t bits)
+    {
+        if(bits & Cell::FLAGGED)
+            _flagged.set(index);
+        else
+            _flagged.reset(index);
+    }
+
+public:
+    Move_History(){};
+    Move_History(const Move_History&) = delete;
+    Move_History& operator=(const Move_History&) = delete;
+
+    // forget everything and start from a room in this state
+    void reset(const Bit_Board& planes, std::int64_t cells_selected);
+    // a move just changed these cells, contents has them the way it left them
+    // selected_before and selected_after are number_selected() either side of it
+    void record(bool flag, std::span<const std::int64_t> changed, const Cell* contents, std::int64_t selected_before,
+                std::int64_t selected_after, const Bit_Board& planes);
+
+    std::int64_t current() const { return _current; }
+    std::int64_t moves() const { return std::int64_t(_first.size()) - 1; }
+    std::int64_t cells_selected() const { return _selected.empty() ? 0 : _selected[_current]; }
+    // a checkpoint that gets to move for less than walking there from current() does, null if there isn't one
+    const Checkpoint* shortcut(std::int64_t move) const;
+    // the room's been put back the way checkpoint has it
+    void restored(const Checkpoint& checkpoint);
+    // undo or redo one move at a time until move is current(), calling put(index, bits) for every cell that changes
+    template<typename Put> void walk(std::int64_t move, Put&& put)
+    {
+        for(; _current > move; --_current) {
+            for(std::int64_t i = _first[_current] - 1; i >= _first[_current - 1]; --i) {
+                put(_changes[i].index, _changes[i].before);
+                set_flag(_changes[i].index, _changes[i].before);
+            }
+        }
+        for(; _current < move; ++_current) {
+            for(std::int64_t i = _first[_current]; i < _first[_current + 1]; ++i) {
+                put(_changes[i].index, _changes[i].after);
+                set_flag(_changes[i].index, _changes[i].after);
+            }
+        }
+    }
+};
+} // namespace mouthbreather
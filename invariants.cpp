@@ -0,0 +1,647 @@
+/* checks on random rooms that the game does what the slow, obvious way of doing the same thing says it should
+ * every check says what it compares above it, and adds up how many cases it looked at and how many were wrong
+ *
+ * invariants [--rooms N]
+ * run by make check, prints what failed and exits 1 if anything did
+ */
+
+#include "chunked_board.hpp"
+#include "history.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
+#include "no_guess.hpp"
+#include "server.hpp"
+#include "solver.hpp"
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+constexpr int DEFAULT_ROOMS_ = 200; // rooms per check
+constexpr int REPORT_LIMIT_ = 5;    // failures printed per check before it stops saying
+
+struct Check {
+    const char* name;
+    std::int64_t cases = 0;
+    std::int64_t failures = 0;
+
+    // true if it held, the first few that didn't get printed
+    bool expect(bool held, const std::string& what)
+    {
+        ++cases;
+        if(!held && ++failures <= REPORT_LIMIT_)
+            std::fprintf(stderr, "%s: %s\n", name, what.c_str());
+        return held;
+    }
+};
+
+Coordinates random_cell(Random_Generator& random, Coordinates size)
+{
+    return Coordinates(int(random.below(size.x)) + 1, int(random.below(size.y)) + 1);
+}
+
+// every playable cell, the room's own order
+std::vector<std::int64_t> cells_of(Grid& room)
+{
+    std::vector<std::int64_t> cells;
+    Coordinates size = room.room_size();
+    for(int y = 1; y <= size.y; ++y) {
+        for(int x = 1; x <= size.x; ++x) {
+            Coordinates cell(x, y);
+            cells.push_back(room.index_of(cell));
+        }
+    }
+    return cells;
+}
+
+// a cell with no mouthbreathers around it, the kind an opening is made of
+bool empty_cell(Grid& room, std::int64_t index)
+{
+    const Bit_Board& planes = room.planes();
+    return planes.playable.test(index) && !planes.mouthbreathers.test(index) &&
+           planes.around(planes.mouthbreathers, index) == 0;
+}
+
+// everything anyone can see or ask about a room
+struct Snapshot {
+    std::vector<char> codes;
+    std::vector<std::uint64_t> revealed;
+    std::vector<std::uint64_t> flagged;
+    std::int64_t selected;
+    bool lost;
+    bool won;
+
+    bool operator==(const Snapshot& other) const = default;
+};
+
+Snapshot snapshot(Grid& room)
+{
+    Snapshot taken{ {}, room.planes().revealed.words(), room.planes().flagged.words(), room.number_selected(),
+                    room.lost(), room.won() };
+    for(std::int64_t index : cells_of(room))
+        taken.codes.push_back(room.code_at(index));
+    return taken;
+}
+
+// a server on its own thread for the checks to talk to, stopped the way an operator would stop it
+struct Test_Server {
+    Game_Parameters parameters;
+    std::thread serving;
+    sigset_t stop_signals;
+    sigset_t old_mask;
+
+    bool start(const std::string& path)
+    {
+        parameters.Default();
+        parameters.size = Coordinates(9, 9);
+        parameters.frequency = 0.15f;
+        parameters.seed = 7;
+        parameters.threads = 2;
+        parameters.serve = path;
+        // blocked here too, or the SIGTERM that stops it would stop the whole process
+        sigemptyset(&stop_signals);
+        sigaddset(&stop_signals, SIGINT);
+        sigaddset(&stop_signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+        serving = std::thread([this] { run_server(parameters); });
+        struct stat status;
+        for(int waited = 0; waited < 2000 && stat(path.c_str(), &status) != 0; ++waited)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return stat(path.c_str(), &status) == 0;
+    }
+    void stop()
+    {
+        kill(getpid(), SIGTERM);
+        serving.join();
+        timespec now{};
+        sigtimedwait(&stop_signals, nullptr, &now); // the server only looks at it, it's still pending
+        pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+    }
+};
+
+// one connection to a Test_Server, a line at a time, a reply that doesn't come within a few seconds is an empty line
+struct Client {
+    int socket = -1;
+    std::string in;
+
+    bool open(const std::string& path)
+    {
+        socket = connect_to(path);
+        timeval timeout{ 5, 0 };
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        return socket >= 0;
+    }
+    ~Client()
+    {
+        if(socket >= 0)
+            ::close(socket);
+    }
+    void send(std::string line)
+    {
+        line += '\n';
+        if(::send(socket, line.data(), line.size(), MSG_NOSIGNAL) < 0)
+            in.clear();
+    }
+    std::string line()
+    {
+        char buffer[1 << 12];
+        std::size_t end;
+        while((end = in.find('\n')) == std::string::npos) {
+            ssize_t count = recv(socket, buffer, sizeof(buffer), 0);
+            if(count <= 0)
+                return "";
+            in.append(buffer, std::size_t(count));
+        }
+        std::string whole = in.substr(0, end);
+        in.erase(0, end + 1);
+        return whole;
+    }
+    bool hung_up() // by the server, rather than it just taking too long to answer
+    {
+        char buffer[1 << 12];
+        return in.empty() && recv(socket, buffer, sizeof(buffer), 0) == 0;
+    }
+};
+
+// small rooms with a few cells opened, the chance under every hidden cell against every layout of the right number
+// of mouthbreathers that fits what's showing, counted one at a time
+void check_probabilities(Check& check, int rooms, const std::string&)
+{
+    Random_Generator random(11);
+    for(int room_number = 0; room_number < rooms; ++room_number) {
+        Coordinates size(int(random.below(3)) + 4, int(random.below(3)) + 3);
+        Grid room(size);
+        Coordinates start = random_cell(random, size);
+        float frequency = 0.15f + float(random.below(15)) / 100;
+        room.seed(start, frequency, random.next());
+        for(int extra = int(random.below(3)); extra > 0; --extra) { // open a little more so it isn't all one shape
+            Coordinates cell = random_cell(random, size);
+            if(!room.planes().mouthbreathers.test(room.index_of(cell)))
+                room.select(cell);
+        }
+        if(room.won())
+            continue;
+
+        std::vector<std::int64_t> hidden;
+        std::vector<std::int64_t> numbers;
+        for(std::int64_t index : cells_of(room))
+            (room.planes().revealed.test(index) ? numbers : hidden).push_back(index);
+        std::int64_t mouthbreathers = room.number_of_mouthbreathers();
+        std::vector<double> mine_layouts(hidden.size(), 0);
+        double layouts = 0;
+        std::vector<char> chosen(hidden.size(), 0);
+        Bit_Plane placed = room.planes().mouthbreathers; // same size, its bits get replaced below
+        auto fits = [&]() {
+            for(std::int64_t number : numbers) {
+                if(placed.test(number) || room.planes().around(placed, number) != room.number_at(number))
+                    return false;
+            }
+            return true;
+        };
+        auto place = [&](auto& self, std::size_t next, std::int64_t left) -> void {
+            if(left == 0) {
+                if(!fits())
+                    return;
+                layouts += 1;
+                for(std::size_t i = 0; i < hidden.size(); ++i)
+                    mine_layouts[i] += chosen[i];
+                return;
+            }
+            if(hidden.size() - next < std::size_t(left))
+                return;
+            chosen[next] = 1;
+            placed.set(hidden[next]);
+            self(self, next + 1, left - 1);
+            chosen[next] = 0;
+            placed.reset(hidden[next]);
+            self(self, next + 1, left);
+        };
+        for(std::uint64_t& word : placed.words())
+            word = 0;
+        place(place, 0, mouthbreathers);
+
+        Solver solver(room);
+        solver.update();
+        if(!solver.probabilities().exact)
+            continue;
+        for(std::size_t i = 0; i < hidden.size(); ++i) {
+            double expected = mine_layouts[i] / layouts;
+            double found = solver.probability(hidden[i]);
+            check.expect(std::abs(found - expected) < 1e-9,
+                         "room " + std::to_string(room_number) + " cell " + std::to_string(hidden[i]) + ": " +
+                             std::to_string(found) + " instead of " + std::to_string(expected));
+        }
+    }
+}
+
+// generate then open_start has to give exactly the room seed does
+void check_seeding(Check& check, int rooms, const std::string&)
+{
+    Random_Generator random(37);
+    for(int room_number = 0; room_number < rooms; ++room_number) {
+        Coordinates size(int(random.below(80)) + 5, int(random.below(80)) + 5);
+        Coordinates start = random_cell(random, size);
+        float frequency = float(random.below(90) + 1) / 100;
+        std::uint64_t random_seed = random.next();
+        Grid whole(size);
+        whole.seed(start, frequency, random_seed);
+        Grid halves(size);
+        halves.generate(frequency, random_seed);
+        halves.open_start(start);
+        check.expect(whole.planes().mouthbreathers.words() == halves.planes().mouthbreathers.words() &&
+                         snapshot(whole) == snapshot(halves) &&
+                         whole.minimum_clicks() == halves.minimum_clicks(),
+                     "room " + std::to_string(room_number) + " came out different in two halves");
+    }
+}
+
+// 3BV and openings against labeling the empty cells with a flood fill, and selecting an empty cell against
+// revealing its opening and everything touching it, which the flood metrics have to count too
+void check_openings(Check& check, int rooms, const std::string&)
+{
+    Random_Generator random(23);
+    for(int room_number = 0; room_number < rooms; ++room_number) {
+        Coordinates size(int(random.below(60)) + 5, int(random.below(40)) + 5);
+        Grid room(size);
+        Coordinates start = random_cell(random, size);
+        float frequency = 0.05f + float(random.below(20)) / 100;
+        room.seed(start, frequency, random.next());
+
+        std::vector<std::int64_t> cells = cells_of(room);
+        std::vector<std::int64_t> label(std::size_t(room.planes().playable.words().size()) * 64, -1);
+        std::vector<std::vector<std::int64_t>> openings;
+        for(std::int64_t cell : cells) {
+            if(!empty_cell(room, cell) || label[cell] >= 0)
+                continue;
+            openings.emplace_back();
+            std::vector<std::int64_t> frontier{ cell };
+            label[cell] = std::int64_t(openings.size()) - 1;
+            while(!frontier.empty()) {
+                std::int64_t current = frontier.back();
+                frontier.pop_back();
+                openings.back().push_back(current);
+                room.for_each_neighbor(current, [&](std::int64_t neighbor) {
+                    if(empty_cell(room, neighbor) && label[neighbor] < 0) {
+                        label[neighbor] = label[cell];
+                        frontier.push_back(neighbor);
+                    }
+                });
+            }
+        }
+        std::int64_t isolated = 0;
+        for(std::int64_t cell : cells) {
+            if(room.planes().mouthbreathers.test(cell) || empty_cell(room, cell))
+                continue;
+            bool touches = false;
+            room.for_each_neighbor(cell,
+                                   [&](std::int64_t neighbor) { touches = touches || empty_cell(room, neighbor); });
+            isolated += !touches;
+        }
+        std::string which = "room " + std::to_string(room_number);
+        check.expect(room.openings() == std::int64_t(openings.size()),
+                     which + ": " + std::to_string(room.openings()) + " openings instead of " +
+                         std::to_string(openings.size()));
+        check.expect(room.minimum_clicks() == std::int64_t(openings.size()) + isolated,
+                     which + ": 3BV " + std::to_string(room.minimum_clicks()) + " instead of " +
+                         std::to_string(std::int64_t(openings.size()) + isolated));
+
+        Game_Metrics metrics;
+        room.set_metrics(&metrics);
+        bool flooded = false;
+        for(int tries = 0; tries < 4 && !openings.empty(); ++tries) {
+            const std::vector<std::int64_t>& opening = openings[random.below(openings.size())];
+            Bit_Plane expected = room.planes().revealed;
+            flooded = flooded || !room.planes().revealed.test(opening[0]);
+            for(std::int64_t cell : opening) {
+                expected.set(cell);
+                room.for_each_neighbor(cell, [&](std::int64_t neighbor) { expected.set(neighbor); });
+            }
+            Coordinates click = room.coordinates_of(opening[random.below(opening.size())]);
+            room.select(click);
+            check.expect(room.planes().revealed.words() == expected.words(),
+                         which + ": selecting an empty cell didn't reveal exactly its opening");
+        }
+        check.expect(!flooded || metrics.deepest_flood >= 1, which + ": opening a room left deepest_flood at 0");
+        room.set_metrics(nullptr);
+    }
+}
+
+// random selects, flags, undos and redos, every state checked against the one it should have gone back or forward
+// to, then the journal of it all replayed onto a fresh room
+void check_history(Check& check, int rooms, const std::string& scratch)
+{
+    Random_Generator random(41);
+    std::string journal_path = scratch + ".journal";
+    for(int room_number = 0; room_number < rooms; ++room_number) {
+        std::string which = "room " + std::to_string(room_number);
+        Game_Parameters parameters;
+        parameters.size = Coordinates(int(random.below(60)) + 5, int(random.below(40)) + 5);
+        parameters.frequency = 0.05f + float(random.below(20)) / 100;
+        parameters.seed = random.next();
+        Move_Journal journal;
+        if(!check.expect(journal.create(journal_path, parameters), which + ": can't write " + journal_path))
+            return;
+        Grid room(parameters.size);
+        Move_History history;
+        room.set_history(&history);
+        room.set_journal(&journal);
+        Coordinates start = random_cell(random, parameters.size);
+        room.seed(start, parameters.frequency, parameters.seed);
+
+        std::vector<Snapshot> states{ snapshot(room) };
+        std::int64_t current = 0;
+        for(int step = 0; step < 200; ++step) {
+            int what = int(random.below(10));
+            if(what < 5) {
+                Coordinates cell = random_cell(random, parameters.size);
+                std::int64_t moves = history.moves();
+                if(what < 2)
+                    room.flag(cell);
+                else
+                    room.select(cell);
+                // a select on a cell that's already revealed isn't a move
+                if(history.moves() != moves || history.current() != current) {
+                    states.resize(std::size_t(current) + 1);
+                    states.push_back(snapshot(room));
+                    ++current;
+                }
+            } else {
+                std::int64_t moves = random.below(4) == 0 ? std::int64_t(random.below(100)) : 1;
+                current += what < 8 ? -room.undo(moves) : room.redo(moves);
+            }
+            if(!check.expect(history.current() == current && snapshot(room) == states[current],
+                             which + ": step " + std::to_string(step) + " isn't the state move " +
+                                 std::to_string(current) + " left"))
+                break;
+        }
+        journal.flush();
+
+        Game_Parameters read_back;
+        Journal_Reader reader;
+        Grid replayed(parameters.size);
+        Move_History replayed_history;
+        replayed.set_history(&replayed_history);
+        if(check.expect(reader.open(journal_path, read_back), which + ": can't read the journal back")) {
+            replay(reader, replayed, read_back.frequency, read_back.seed);
+            check.expect(snapshot(replayed) == snapshot(room), which + ": replaying the journal gave another room");
+        }
+    }
+    unlink(journal_path.c_str());
+}
+
+// rooms part way through a game saved and loaded back, which has to give the same room, frequency included, and
+// metrics that say what it is
+void check_saves(Check& check, int rooms, const std::string& scratch)
+{
+    Random_Generator random(43);
+    std::string path = scratch + ".save";
+    for(int room_number = 0; room_number < rooms; ++room_number) {
+        std::string which = "room " + std::to_string(room_number);
+        Coordinates size(int(random.below(60)) + 5, int(random.below(40)) + 5);
+        Grid room(size);
+        Coordinates start = random_cell(random, size);
+        float frequency = 0.05f + float(random.below(20)) / 100;
+        room.seed(start, frequency, random.next());
+        for(int moves = int(random.below(20)); moves > 0 && !room.lost(); --moves) {
+            Coordinates cell = random_cell(random, size);
+            if(random.below(3) == 0)
+                room.flag(cell);
+            else
+                room.select(cell);
+        }
+        if(!check.expect(room.save(path), which + ": can't save"))
+            continue;
+        std::unique_ptr<Grid> loaded = Grid::load(path);
+        if(!check.expect(loaded != nullptr, which + ": can't load the save back"))
+            continue;
+        check.expect(snapshot(*loaded) == snapshot(room) &&
+                         loaded->planes().mouthbreathers.words() == room.planes().mouthbreathers.words() &&
+                         loaded->random_seed() == room.random_seed() &&
+                         loaded->minimum_clicks() == room.minimum_clicks(),
+                     which + ": loading the save gave another room");
+        Game_Metrics metrics;
+        loaded->set_metrics(&metrics);
+        check.expect(loaded->frequency() == room.frequency() && metrics.frequency == room.frequency() &&
+                         metrics.width == size.x && metrics.height == size.y &&
+                         metrics.mouthbreathers == room.number_of_mouthbreathers(),
+                     which + ": the loaded room's metrics say frequency " + std::to_string(metrics.frequency) +
+                         " instead of " + std::to_string(room.frequency()));
+    }
+    unlink(path.c_str());
+}
+
+// unbounded rooms: nothing can be flagged before the first select, which is always safe, nothing outside in_range()
+// can be touched, a 0 the first select opened up has every cell around it open, and the same seed gives the same
+// numbers whatever order the room gets explored in
+void check_chunks(Check& check, int rooms, const std::string&)
+{
+    Random_Generator random(47);
+    for(int room_number = 0; room_number < std::max(rooms / 10, 1); ++room_number) {
+        std::string which = "room " + std::to_string(room_number);
+        float frequency = 0.1f + float(random.below(15)) / 100;
+        std::uint64_t random_seed = random.next();
+        auto anywhere = [&] { return std::int64_t(random.below(2 * UNBOUNDED_LIMIT_ - 2 * FLOOD_RADIUS_)) -
+                                     UNBOUNDED_LIMIT_ + FLOOD_RADIUS_; };
+        std::int64_t start_x = anywhere();
+        std::int64_t start_y = anywhere();
+
+        Chunked_Board board(frequency, random_seed);
+        check.expect(!board.flag(start_x, start_y) && board.chunks() == 0, which + ": flagged before the first select");
+        check.expect(!board.flag(UNBOUNDED_LIMIT_ + 1, 0) && board.select(0, -UNBOUNDED_LIMIT_ - 1) &&
+                         board.cells_revealed() == 0 && board.chunks() == 0,
+                     which + ": touched a cell outside the room");
+        check.expect(board.select(start_x, start_y) && board.number_at(start_x, start_y) == 0,
+                     which + ": the first select wasn't safe and empty");
+        bool holes = false;
+        for(std::int64_t y = start_y - FLOOD_RADIUS_ + 1; y < start_y + FLOOD_RADIUS_; ++y) {
+            for(std::int64_t x = start_x - FLOOD_RADIUS_ + 1; x < start_x + FLOOD_RADIUS_; ++x) {
+                if(board.number_at(x, y) != 0)
+                    continue;
+                for(std::int64_t around = 0; around < 9; ++around)
+                    holes = holes || !board.revealed(x + around % 3 - 1, y + around / 3 - 1);
+            }
+        }
+        check.expect(!holes, which + ": a 0 the first select opened up has a hidden cell next to it");
+        board.flag(start_x, start_y); // revealed, so it stays unflagged
+        check.expect(!board.flagged(start_x, start_y) && board.flag(start_x + FLOOD_RADIUS_ + 1, start_y) &&
+                         board.flagged(start_x + FLOOD_RADIUS_ + 1, start_y),
+                     which + ": flags after the first select went wrong");
+
+        // somewhere well clear of the start, explored straight away on one board and after a detour on the other
+        std::int64_t far_x = start_x + 8 * CHUNK_SIZE_;
+        std::int64_t far_y = start_y - 8 * CHUNK_SIZE_;
+        Chunked_Board detour(frequency, random_seed);
+        detour.select(start_x, start_y);
+        detour.select(start_x - 8 * CHUNK_SIZE_, start_y + 8 * CHUNK_SIZE_);
+        bool safe = board.select(far_x, far_y);
+        bool same = detour.select(far_x, far_y) == safe;
+        for(std::int64_t y = far_y - FLOOD_RADIUS_; y <= far_y + FLOOD_RADIUS_ && same; ++y) {
+            for(std::int64_t x = far_x - FLOOD_RADIUS_; x <= far_x + FLOOD_RADIUS_; ++x)
+                same = same && board.revealed(x, y) == detour.revealed(x, y) &&
+                       board.number_at(x, y) == detour.number_at(x, y);
+        }
+        check.expect(same, which + ": exploring in another order gave other numbers");
+    }
+}
+
+// rooms made not to need a guess, played out by the solver one proven safe cell at a time, which must never be a
+// mouthbreather and must get all the way to a win, and the same board found whatever number of threads looks
+void check_no_guess(Check& check, int rooms, const std::string&)
+{
+    Random_Generator random(53);
+    for(int room_number = 0; room_number < std::max(rooms / 20, 1); ++room_number) {
+        std::string which = "room " + std::to_string(room_number);
+        Coordinates size(int(random.below(8)) + 9, int(random.below(8)) + 9);
+        Coordinates click = random_cell(random, size);
+        float frequency = 0.1f + float(random.below(7)) / 100;
+        std::uint64_t random_seed = random.next();
+
+        No_Guess_Board alone;
+        No_Guess_Board together;
+        bool found = find_no_guess_board(size, click, frequency, random_seed, 1, alone);
+        check.expect(find_no_guess_board(size, click, frequency, random_seed, 3, together) == found &&
+                         (!found || together.random_seed == alone.random_seed),
+                     which + ": three threads found another board than one did");
+        std::atomic<bool> stop = true;
+        No_Guess_Board stopped;
+        check.expect(!find_no_guess_board(size, click, frequency, random_seed, 2, stopped, NO_GUESS_ATTEMPT_LIMIT_,
+                                          &stop),
+                     which + ": kept looking after being told to stop");
+
+        Grid room(size);
+        bool verified = seed_without_guessing(room, click, frequency, random_seed, 2);
+        check.expect(verified == found && room.random_seed() == (found ? alone.random_seed : random_seed),
+                     which + ": seeded from another seed than the search found");
+        if(!verified)
+            continue;
+        Solver solver(room);
+        bool guessed = false;
+        while(!room.won() && !room.lost()) {
+            solver.update();
+            std::int64_t index = solver.next_safe();
+            if(index < 0 || room.planes().mouthbreathers.test(index)) {
+                guessed = true;
+                break;
+            }
+            Coordinates choice = room.coordinates_of(index);
+            room.select(choice);
+        }
+        check.expect(!guessed && room.won(), which + ": needed a guess after all");
+    }
+}
+
+// the server's answers to the moves a client makes, starting with a flag before the first select, which used to flag
+// a room that seeding then laid out over the top of, then that it answers and hangs up on a client that stops sending
+// and takes its socket file with it when it stops
+void check_server(Check& check, int rooms, const std::string& scratch)
+{
+    std::string path = scratch + ".socket";
+    Test_Server server;
+    if(!check.expect(server.start(path), "the server didn't start listening on " + path))
+        return;
+    {
+        Client client;
+        if(check.expect(client.open(path), "can't connect")) {
+            std::string line = client.line();
+            for(int room_number = 0; room_number < std::max(rooms / 20, 1); ++room_number) {
+                std::string which = "room " + std::to_string(room_number);
+                if(room_number > 0) {
+                    client.send("n");
+                    line = client.line();
+                }
+                check.expect(line.starts_with("game 9 9 "), which + ": " + line + " instead of a new room");
+                client.send("f 1 A");
+                line = client.line();
+                check.expect(line == "error select somewhere first",
+                             which + ": " + line + " for a flag before a select");
+                client.send("s 5 E");
+                line = client.line();
+                check.expect((line.starts_with("play ") || line.starts_with("won ")) &&
+                                 line.find('+') == std::string::npos,
+                             which + ": " + line + " for the first select");
+                if(!line.starts_with("play "))
+                    continue;
+                // a cell the select didn't open, its flag has to come and go with f
+                std::string hidden;
+                for(int row = 0; row < 9 && hidden.empty(); ++row) {
+                    for(int x = 1; x <= 9 && hidden.empty(); ++x) {
+                        std::string cell = std::to_string(x) + " " + number_to_letter(row + 1);
+                        if(line.find(" " + cell + " ") == std::string::npos)
+                            hidden = cell;
+                    }
+                }
+                client.send("f " + hidden);
+                std::string flagged = client.line();
+                client.send("f " + hidden);
+                std::string unflagged = client.line();
+                check.expect(flagged == "play 1 " + hidden + " +" && unflagged == "play 1 " + hidden + " .",
+                             which + ": flagging " + hidden + " twice said " + flagged + " then " + unflagged);
+            }
+        }
+    }
+    for(int room_number = 0; room_number < std::max(rooms / 20, 1); ++room_number) {
+        std::string which = "half closed " + std::to_string(room_number);
+        Client client;
+        if(!check.expect(client.open(path), "can't connect"))
+            continue;
+        client.line();
+        for(int move = 0; move < 50; ++move)
+            client.send(move % 2 ? "u" : "s 5 E");
+        shutdown(client.socket, SHUT_WR);
+        int answered = 0;
+        while(!client.line().empty())
+            ++answered;
+        check.expect(answered == 50, which + ": " + std::to_string(answered) + " answers to 50 moves");
+        check.expect(client.hung_up(), which + ": still connected after the last answer");
+    }
+    server.stop();
+    struct stat status;
+    check.expect(stat(path.c_str(), &status) != 0, path + " is still there after the server stopped");
+}
+
+struct Test {
+    const char* name;
+    void (*run)(Check& check, int rooms, const std::string& scratch); // scratch is a path prefix for any files
+};
+
+const Test TESTS_[] = {
+    { "probabilities", check_probabilities },
+    { "seeding", check_seeding },
+    { "openings", check_openings },
+    { "history", check_history },
+    { "saves", check_saves },
+    { "chunks", check_chunks },
+    { "no_guess", check_no_guess },
+    { "server", check_server },
+};
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int rooms = DEFAULT_ROOMS_;
+    for(int i = 1; i < argc; i += 2) {
+        if(std::string(argv[i]) == "--rooms" && i + 1 < argc)
+            rooms = std::max(std::atoi(argv[i + 1]), 1);
+        else
+            std::cerr << "ignoring " << argv[i] << std::endl;
+    }
+    std::string scratch = "/tmp/mouthbreather_invariants_" + std::to_string(getpid());
+
+    bool passed = true;
+    for(const Test& test : TESTS_) {
+        Check check{ test.name };
+        test.run(check, rooms, scratch);
+        std::printf("%-14s %lld cases, %lld failed\n", check.name, (long long)check.cases, (long long)check.failures);
+        passed = passed && check.failures == 0 && check.cases > 0;
+    }
+    return passed ? 0 : 1;
+}
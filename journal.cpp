@@ -0,0 +1,253 @@
+#include "journal.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+constexpr char JOURNAL_MAGIC_[8] = { 'M', 'B', 'J', 'O', 'U', 'R', 'N', 'L' };
+
+void put_varint(std::string& out, std::uint64_t value)
+{
+    while(value >= 0x80) {
+        out += char(std::uint8_t(value) | 0x80);
+        value >>= 7;
+    }
+    out += char(value);
+}
+
+// false if the varint runs past end
+bool get_varint(const std::uint8_t*& at, const std::uint8_t* end, std::uint64_t& value)
+{
+    value = 0;
+    for(int shift = 0; at < end && shift < 64; shift += 7) {
+        std::uint8_t byte = *at++;
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// small negative distances stay small: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+std::uint64_t zigzag(std::int64_t value)
+{
+    return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t value)
+{
+    return std::int64_t(value >> 1) ^ -std::int64_t(value & 1);
+}
+
+bool write_all(int file, const std::string& data)
+{
+    std::size_t written = 0;
+    while(written < data.size()) {
+        ssize_t result = ::write(file, data.data() + written, data.size() - written);
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+            return false;
+        written += std::size_t(result);
+    }
+    return true;
+}
+} // namespace
+
+mouthbreather::Move_Journal::~Move_Journal()
+{
+    if(_file < 0)
+        return;
+    flush();
+    ::close(_file);
+}
+
+// start a new journal
+bool mouthbreather::Move_Journal::create(const std::string& path, Game_Parameters& parameters)
+{
+    _file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(_file < 0) {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::uint32_t frequency_bits;
+    std::memcpy(&frequency_bits, &parameters.frequency, sizeof(frequency_bits));
+    _pending.assign(JOURNAL_MAGIC_, sizeof(JOURNAL_MAGIC_));
+    put_varint(_pending, JOURNAL_VERSION_);
+    put_varint(_pending, std::uint64_t(parameters.size.x));
+    put_varint(_pending, std::uint64_t(parameters.size.y));
+    put_varint(_pending, frequency_bits);
+    put_varint(_pending, parameters.seed);
+    _last = Coordinates(0, 0);
+    _random_seed = parameters.seed;
+    flush();
+    return true;
+}
+
+// carry on with a journal that was just replayed
+bool mouthbreather::Move_Journal::resume(const std::string& path, std::size_t length, Coordinates last,
+                                         std::uint64_t random_seed)
+{
+    _file = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    if(_file < 0 || ftruncate(_file, off_t(length)) != 0) {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    _pending.clear();
+    _last = last;
+    _random_seed = random_seed;
+    return true;
+}
+
+void mouthbreather::Move_Journal::record(Journal_Action action, Coordinates location)
+{
+    _pending += char(action);
+    put_varint(_pending, zigzag(std::int64_t(location.x) - _last.x));
+    put_varint(_pending, zigzag(std::int64_t(location.y) - _last.y));
+    _last = location;
+    if(_pending.size() >= JOURNAL_FLUSH_BYTES_)
+        flush();
+}
+
+void mouthbreather::Move_Journal::record_count(Journal_Action action, std::int64_t moves)
+{
+    _pending += char(action);
+    put_varint(_pending, std::uint64_t(moves));
+    if(_pending.size() >= JOURNAL_FLUSH_BYTES_)
+        flush();
+}
+
+// only rooms that weren't made from the header's seed need to say which one they were made from
+void mouthbreather::Move_Journal::record_seed(Coordinates avoid, std::uint64_t random_seed)
+{
+    if(random_seed == _random_seed) {
+        record(Journal_Action::seed, avoid);
+        return;
+    }
+    _pending += char(Journal_Action::seed_with);
+    put_varint(_pending, zigzag(std::int64_t(avoid.x) - _last.x));
+    put_varint(_pending, zigzag(std::int64_t(avoid.y) - _last.y));
+    put_varint(_pending, random_seed);
+    _last = avoid;
+}
+
+// hand everything recorded so far to the operating system
+void mouthbreather::Move_Journal::flush()
+{
+    if(_file < 0 || _pending.empty())
+        return;
+    if(!write_all(_file, _pending))
+        std::cerr << "couldn't write to the journal: " << std::strerror(errno) << std::endl;
+    _pending.clear();
+}
+
+mouthbreather::Journal_Reader::~Journal_Reader()
+{
+    if(_begin)
+        munmap(const_cast<std::uint8_t*>(_begin), _mapped);
+}
+
+// open path and read its header
+bool mouthbreather::Journal_Reader::open(const std::string& path, Game_Parameters& parameters)
+{
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    struct stat status;
+    if(fstat(file, &status) == 0 && std::size_t(status.st_size) > sizeof(JOURNAL_MAGIC_)) {
+        _mapped = std::size_t(status.st_size);
+        void* mapping = mmap(nullptr, _mapped, PROT_READ, MAP_PRIVATE, file, 0);
+        if(mapping != MAP_FAILED) {
+            madvise(mapping, _mapped, MADV_SEQUENTIAL);
+            _begin = static_cast<const std::uint8_t*>(mapping);
+            _end = _begin + _mapped;
+        }
+    }
+    ::close(file);
+    if(!_begin || std::memcmp(_begin, JOURNAL_MAGIC_, sizeof(JOURNAL_MAGIC_)) != 0) {
+        std::cerr << path << ": not a journal" << std::endl;
+        return false;
+    }
+
+    _next = _begin + sizeof(JOURNAL_MAGIC_);
+    std::uint64_t version, width, height, frequency_bits, seed;
+    if(!get_varint(_next, _end, version) || !get_varint(_next, _end, width) || !get_varint(_next, _end, height) ||
+       !get_varint(_next, _end, frequency_bits) || !get_varint(_next, _end, seed)) {
+        std::cerr << path << ": the journal was cut short" << std::endl;
+        return false;
+    }
+    if(version < JOURNAL_OLDEST_VERSION_ || version > JOURNAL_VERSION_) {
+        std::cerr << path << ": written by a different version" << std::endl;
+        return false;
+    }
+    if(width < std::uint64_t(SIZE_MININUM_) || height < std::uint64_t(SIZE_MININUM_) ||
+       width > std::uint64_t(SIZE_LIMIT_) || height > std::uint64_t(SIZE_LIMIT_)) {
+        std::cerr << path << ": the room in it is the wrong size" << std::endl;
+        return false;
+    }
+    std::uint32_t frequency = std::uint32_t(frequency_bits);
+    parameters.size = Coordinates(int(width), int(height));
+    std::memcpy(&parameters.frequency, &frequency, sizeof(frequency));
+    parameters.seed = seed;
+    _last = Coordinates(0, 0);
+    return true;
+}
+
+// the next whole entry
+bool mouthbreather::Journal_Reader::next(Journal_Entry& entry)
+{
+    const std::uint8_t* at = _next;
+    std::uint64_t x, y;
+    if(at >= _end || *at > std::uint8_t(Journal_Action::redo))
+        return false;
+    entry.action = Journal_Action(*at++);
+    if(entry.action == Journal_Action::undo || entry.action == Journal_Action::redo) {
+        std::uint64_t moves;
+        if(!get_varint(at, _end, moves))
+            return false;
+        entry.moves = std::int64_t(moves);
+        entry.location = _last;
+        _next = at;
+        return true;
+    }
+    if(!get_varint(at, _end, x) || !get_varint(at, _end, y))
+        return false;
+    if(entry.action == Journal_Action::seed_with && !get_varint(at, _end, entry.random_seed))
+        return false;
+    entry.location = Coordinates(int(_last.x + unzigzag(x)), int(_last.y + unzigzag(y)));
+    _last = entry.location;
+    _next = at;
+    return true;
+}
+
+// apply the journal to a fresh room, drawing nothing
+std::int64_t mouthbreather::replay(Journal_Reader& journal, Grid& room, float frequency, std::uint64_t random_seed,
+                                   std::int64_t moves)
+{
+    Journal_Entry entry;
+    std::int64_t applied = 0;
+    while((moves < 0 || applied < moves) && journal.next(entry)) {
+        ++applied;
+        if(entry.action == Journal_Action::seed)
+            room.seed(entry.location, frequency, random_seed);
+        else if(entry.action == Journal_Action::seed_with)
+            room.seed(entry.location, frequency, entry.random_seed);
+        else if(entry.action == Journal_Action::flag)
+            room.flag(entry.location);
+        else if(entry.action == Journal_Action::undo)
+            room.undo(entry.moves);
+        else if(entry.action == Journal_Action::redo)
+            room.redo(entry.moves);
+        else
+            room.select(entry.location);
+    }
+    return applied;
+}
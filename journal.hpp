@@ -0,0 +1,92 @@
+#pragma once
+#include "mouthbreather.hpp"
+
+namespace mouthbreather
+{
+constexpr std::uint64_t JOURNAL_VERSION_ = 3; // 3 adds undo and redo, 2 laid the room out before clearing the start
+constexpr std::uint64_t JOURNAL_OLDEST_VERSION_ = 2; // a 2 never has an undo or redo in it, so it still reads the same
+constexpr std::size_t JOURNAL_FLUSH_BYTES_ = 1 << 16; // write out at least this often even if nobody calls flush()
+
+// what a journal entry did
+// seed_with is a seed with a different random seed than the one in the header (a room made without guessing), it's
+// followed by that seed as a varint
+// undo and redo take back or put back some number of moves, and are followed by only that number as a varint
+enum class Journal_Action : std::uint8_t { seed = 0, select = 1, flag = 2, seed_with = 3, undo = 4, redo = 5 };
+
+struct Journal_Entry {
+    Journal_Action action = Journal_Action::select;
+    Coordinates location;
+    std::uint64_t random_seed = 0; // only for seed_with
+    std::int64_t moves = 0;        // only for undo and redo
+};
+
+/* a record of a game that only ever gets added to
+ * an 8 byte magic number, then the version, size, frequency and seed as varints, then one entry per seed, select or
+ * flag: the action in a byte and the distance from the previous entry's location as two zigzag varints, so a move
+ * next to the last one takes 3 bytes, a seed made from some other random seed than the header's has it after that
+ * an undo or redo has no location, just how many moves it went back or forward
+ * a Grid given one with set_journal() records into it, replaying the entries on a fresh Grid with the same
+ * parameters gives back the same room
+ */
+class Move_Journal
+{
+    int _file = -1;
+    std::string _pending; // recorded but not written yet
+    Coordinates _last = Coordinates(0, 0);
+    std::uint64_t _random_seed = 0; // the one in the header
+
+    void record(Journal_Action action, Coordinates location);
+    void record_count(Journal_Action action, std::int64_t moves);
+
+public:
+    Move_Journal(){};
+    Move_Journal(const Move_Journal&) = delete;
+    Move_Journal& operator=(const Move_Journal&) = delete;
+    ~Move_Journal();
+
+    // start a new journal at path for a game with these parameters, false if it can't be written
+    bool create(const std::string& path, Game_Parameters& parameters);
+    // carry on with a journal that was just replayed, cutting it back to the first length bytes in case the last
+    // entry was only half written when the game stopped, random_seed is the one in its header
+    bool resume(const std::string& path, std::size_t length, Coordinates last, std::uint64_t random_seed);
+
+    void record_seed(Coordinates avoid, std::uint64_t random_seed);
+    void record_select(Coordinates location) { record(Journal_Action::select, location); }
+    void record_flag(Coordinates location) { record(Journal_Action::flag, location); }
+    void record_undo(std::int64_t moves) { record_count(Journal_Action::undo, moves); }
+    void record_redo(std::int64_t moves) { record_count(Journal_Action::redo, moves); }
+    // hand everything recorded so far to the operating system, so it's kept even if the game crashes
+    void flush();
+};
+
+// reads a journal back, the file is memory mapped and entries are decoded in place
+class Journal_Reader
+{
+    const std::uint8_t* _begin = nullptr;
+    const std::uint8_t* _next = nullptr;
+    const std::uint8_t* _end = nullptr;
+    std::size_t _mapped = 0;
+    Coordinates _last = Coordinates(0, 0);
+
+public:
+    Journal_Reader(){};
+    Journal_Reader(const Journal_Reader&) = delete;
+    Journal_Reader& operator=(const Journal_Reader&) = delete;
+    ~Journal_Reader();
+
+    // open path and read its header into parameters, false (with a message on std::cerr) if it isn't a journal
+    bool open(const std::string& path, Game_Parameters& parameters);
+    // the next whole entry, false at the end of the journal or at an entry that was cut short
+    bool next(Journal_Entry& entry);
+    // how many bytes of the file have been read as whole entries
+    std::size_t length() { return std::size_t(_next - _begin); }
+    // where the last entry read was
+    Coordinates last() { return _last; }
+};
+
+// apply up to moves entries (all of them if moves is negative) to a fresh room, drawing nothing, and return how many
+// were applied, the room needs a Move_History if the journal has undos or redos in it
+// a select that hits a mouthbreather only ends the game if it isn't taken back, so it doesn't stop the replay
+std::int64_t replay(Journal_Reader& journal, Grid& room, float frequency, std::uint64_t random_seed,
+                    std::int64_t moves = -1);
+} // namespace mouthbreather
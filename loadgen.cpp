@@ -0,0 +1,266 @@
+/* load for a mouthbreather --serve server
+ * every client is a thread with its own connection, playing one move at a time and waiting for the answer before
+ * the next, it selects cells next to the empty ones it has cleared and guesses at random when there are none, and
+ * starts a new room whenever a game ends, so the server sees the mix of moves and new rooms real players make
+ *
+ * loadgen --connect ADDRESS [--clients N] [--seconds S] [--size X Y] [--frequency F]
+ * prints moves/second and the round trip latency percentiles for every command sent
+ */
+
+#include "mouthbreather.hpp"
+#include "server.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr int DEFAULT_CLIENTS_ = 16;
+constexpr double DEFAULT_SECONDS_ = 5;
+
+struct Load_Options {
+    std::string address;
+    int clients = DEFAULT_CLIENTS_;
+    double seconds = DEFAULT_SECONDS_;
+    Coordinates size = Coordinates(16, 16);
+    float frequency = 0.15f;
+};
+
+struct Client_Results {
+    std::int64_t moves = 0;
+    std::int64_t games = 0;
+    std::int64_t errors = 0;
+    std::vector<double> latencies; // seconds, one per command
+    bool failed = false;
+};
+
+Load_Options get_options(int number_of_arguments, char** arguments)
+{
+    Load_Options options;
+    for(int i = 1; i < number_of_arguments; ++i) {
+        std::string flag = arguments[i];
+        int values = flag == "--size" ? 2 : 1;
+        if(i + values >= number_of_arguments) {
+            std::cerr << flag << " needs " << values << " value(s) after it" << std::endl;
+            break;
+        }
+        if(flag == "--connect")
+            options.address = arguments[i + 1];
+        else if(flag == "--clients")
+            options.clients = std::max(std::atoi(arguments[i + 1]), 1);
+        else if(flag == "--seconds")
+            options.seconds = std::atof(arguments[i + 1]);
+        else if(flag == "--size")
+            options.size = Coordinates(std::atoi(arguments[i + 1]), std::atoi(arguments[i + 2]));
+        else if(flag == "--frequency")
+            options.frequency = float(std::atof(arguments[i + 1]));
+        else
+            std::cerr << "ignoring " << flag << std::endl;
+        i += values;
+    }
+    return options;
+}
+
+// one connection, a line at a time
+class Connection
+{
+    int _socket;
+    std::string _in;
+
+public:
+    Connection(int socket)
+        : _socket(socket){};
+    ~Connection()
+    {
+        if(_socket >= 0)
+            close(_socket);
+    }
+    bool send_line(const std::string& line)
+    {
+        std::size_t sent = 0;
+        while(sent < line.size()) {
+            ssize_t count = ::send(_socket, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+            if(count <= 0)
+                return false;
+            sent += std::size_t(count);
+        }
+        return true;
+    }
+    // the next line without its newline, false if the server hung up
+    bool read_line(std::string& line)
+    {
+        std::size_t end;
+        while((end = _in.find('\n')) == std::string::npos) {
+            char buffer[1 << 14];
+            ssize_t count = ::recv(_socket, buffer, sizeof(buffer), 0);
+            if(count <= 0)
+                return false;
+            _in.append(buffer, std::size_t(count));
+        }
+        line.assign(_in, 0, end);
+        _in.erase(0, end + 1);
+        return true;
+    }
+};
+
+// what the client knows about its room, from the server's answers
+struct Known_Room {
+    Coordinates size = Coordinates(0, 0);
+    std::vector<char> cells; // row-major from the top, A is row 0
+    std::vector<int> safe;   // hidden cells next to a revealed 0, selecting them can't lose
+
+    void reset(Coordinates room_size)
+    {
+        size = room_size;
+        cells.assign(std::size_t(size.x) * size.y, '.');
+        safe.clear();
+    }
+    // apply "STATE COUNT x Y C..." and return STATE
+    std::string_view apply(std::string_view reply)
+    {
+        std::size_t space = reply.find(' ');
+        std::string_view state = reply.substr(0, space);
+        const char* at = reply.data() + space + 1;
+        const char* end = reply.data() + reply.size();
+        std::int64_t count = 0;
+        at = std::from_chars(at, end, count).ptr;
+        for(std::int64_t i = 0; i < count && at < end; ++i) {
+            int x = 0;
+            at = std::from_chars(at + 1, end, x).ptr;
+            const char* letters = ++at;
+            while(at < end && *at != ' ')
+                ++at;
+            int row = letter_to_number(std::string_view(letters, std::size_t(at - letters)));
+            char code = at + 1 < end ? at[1] : '.';
+            at += 2;
+            if(row < 0 || x < 1 || x > size.x || row >= size.y)
+                continue;
+            int index = row * size.x + (x - 1);
+            cells[index] = code;
+            if(code == '0') {
+                for(int dy = -1; dy <= 1; ++dy) {
+                    for(int dx = -1; dx <= 1; ++dx) {
+                        int nx = x - 1 + dx;
+                        int ny = row + dy;
+                        if(nx >= 0 && ny >= 0 && nx < size.x && ny < size.y && cells[ny * size.x + nx] == '.')
+                            safe.push_back(ny * size.x + nx);
+                    }
+                }
+            }
+        }
+        return state;
+    }
+    // a hidden cell to select, a safe one if there is one
+    int pick(Random_Generator& random)
+    {
+        while(!safe.empty()) {
+            int index = safe.back();
+            safe.pop_back();
+            if(cells[index] == '.')
+                return index;
+        }
+        for(;;) {
+            int index = int(random.below(cells.size()));
+            if(cells[index] == '.')
+                return index;
+        }
+    }
+};
+
+void play(Load_Options& options, int id, Clock::time_point stop, Client_Results& results)
+{
+    int socket = connect_to(options.address);
+    if(socket < 0) {
+        results.failed = true;
+        return;
+    }
+    Connection connection(socket);
+    Random_Generator random(std::uint64_t(id) + 1);
+    Known_Room room;
+    std::string line;
+    std::string command = "n " + std::to_string(options.size.x) + " " + std::to_string(options.size.y) + " " +
+                          std::to_string(options.frequency) + "\n";
+    if(!connection.read_line(line)) { // the room it starts with
+        results.failed = true;
+        return;
+    }
+    bool new_game = true;
+    while(Clock::now() < stop) {
+        if(!new_game) {
+            int index = room.pick(random);
+            command = "s " + std::to_string(index % room.size.x + 1) + " " + number_to_letter(index / room.size.x + 1) +
+                      "\n";
+        }
+        Clock::time_point sent = Clock::now();
+        if(!connection.send_line(command) || !connection.read_line(line)) {
+            results.failed = true;
+            return;
+        }
+        results.latencies.push_back(std::chrono::duration<double>(Clock::now() - sent).count());
+        if(line.starts_with("error")) {
+            ++results.errors;
+            new_game = true;
+        } else if(new_game) {
+            room.reset(options.size);
+            ++results.games;
+            new_game = false;
+        } else {
+            ++results.moves;
+            std::string_view state = room.apply(line);
+            new_game = state != "play";
+        }
+        if(new_game)
+            command = "n " + std::to_string(options.size.x) + " " + std::to_string(options.size.y) + " " +
+                      std::to_string(options.frequency) + "\n";
+    }
+    connection.send_line("q\n");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Load_Options options = get_options(argc, argv);
+    if(options.address.empty()) {
+        std::cerr << "loadgen --connect ADDRESS [--clients N] [--seconds S] [--size X Y] [--frequency F]" << std::endl;
+        return 1;
+    }
+    std::vector<Client_Results> results(options.clients);
+    Clock::time_point start = Clock::now();
+    Clock::time_point stop = start + std::chrono::duration_cast<Clock::duration>(
+                                         std::chrono::duration<double>(options.seconds));
+    std::vector<std::thread> clients;
+    for(int id = 0; id < options.clients; ++id)
+        clients.emplace_back(play, std::ref(options), id, stop, std::ref(results[id]));
+    for(std::thread& client : clients)
+        client.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Client_Results total;
+    int failed = 0;
+    for(Client_Results& client : results) {
+        total.moves += client.moves;
+        total.games += client.games;
+        total.errors += client.errors;
+        total.latencies.insert(total.latencies.end(), client.latencies.begin(), client.latencies.end());
+        failed += client.failed;
+    }
+    std::sort(total.latencies.begin(), total.latencies.end());
+    auto percentile = [&](double fraction) {
+        if(total.latencies.empty())
+            return 0.0;
+        std::size_t at = std::min(total.latencies.size() - 1, std::size_t(fraction * total.latencies.size()));
+        return total.latencies[at] * 1e6;
+    };
+    std::printf("clients: %d (%d failed) for %.2f s\n", options.clients, failed, seconds);
+    std::printf("moves: %lld (%.0f/s), new rooms: %lld, errors: %lld\n", (long long)total.moves,
+                total.moves / seconds, (long long)total.games, (long long)total.errors);
+    std::printf("latency us: p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n", percentile(0.5), percentile(0.9),
+                percentile(0.99), percentile(0.999), percentile(1));
+    return failed == options.clients ? 1 : 0;
+}
@@ -15,8 +15,21 @@
  * checks and clears all neighboring cells
  */
 
+#include "chunked_board.hpp"
+#include "history.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
 #include "mouthbreather.hpp"
+#include "no_guess.hpp"
+#include "renderer.hpp"
+#include "script.hpp"
+#include "server.hpp"
+#include "simulation.hpp"
+#include <chrono>
 #include <iostream>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace mouthbreather;
 
@@ -26,38 +39,177 @@ int main(int argc, char** argv)
     // initialize
     Game_Parameters parameters = get_parameters(argc, argv);
 
-    // create the needed space on the stack
-    Cell ___space_on_stack___[(parameters.size.x + 1) * (parameters.size.y + 1)];
-    Cell* ___cell_ptr_array___[parameters.size.x + 1];
-    for(int i = 0; i < (parameters.size.x + 1); ++i) {
-        ___cell_ptr_array___[i] = &___space_on_stack___[i * (parameters.size.y + 1)];
+    if(parameters.simulate > 0) { // nobody's playing, just see how fast it goes
+        Simulation_Results results = simulate(parameters);
+        report(results, parameters.threads, std::cout);
+        return 0;
+    }
+    if(!parameters.serve.empty()) // other people are playing, over a socket
+        return run_server(parameters) ? 0 : 1;
+    if(parameters.unbounded) { // no edges, so none of the Grid machinery below applies
+        play_unbounded(parameters);
+        return 0;
     }
-    // the nightmare is over
-    Grid room(parameters.size, ___cell_ptr_array___);
 
-    room.display();
-    Coordinates avoid = user_choice(parameters.size);
-    int number_of_mouthbreathers = room.seed(avoid, parameters.frequency);
-    room.display();
+    // a journal being replayed knows the room's size, frequency and seed, and so does one being carried on with
+    struct stat journal_status;
+    bool resuming = parameters.replay.empty() && !parameters.journal.empty() && parameters.load.empty() &&
+                    stat(parameters.journal.c_str(), &journal_status) == 0 && journal_status.st_size > 0;
+    Journal_Reader reader;
+    if(!parameters.replay.empty() || resuming) {
+        if(!reader.open(resuming ? parameters.journal : parameters.replay, parameters))
+            return 1;
+    }
 
-    Coordinates choice;
-    int number_of_selectable_cells = room.size() - number_of_mouthbreathers;
-    while(room.number_selected() < number_of_selectable_cells) {
-        if(wants_to_flag()) {
-            choice = user_choice(parameters.size);
-            room.flag(choice);
+    // the whole room is one allocation, say how big it is before making it in case it's enormous
+    std::unique_ptr<Grid> allocated_room;
+    try {
+        if(!parameters.load.empty()) { // carry on from a save, it knows its own size, frequency and seed
+            allocated_room = Grid::load(parameters.load);
+            if(!allocated_room)
+                return 1;
+            parameters.size = allocated_room->room_size();
+            parameters.seed = allocated_room->random_seed();
+            parameters.frequency = allocated_room->frequency();
         } else {
-            choice = user_choice(parameters.size);
-            if(!room.select(choice)) // gross, shared space with a mouthbreather
-            {
-                room.display();
-                break;
+            std::cout << "clearing out " << Grid::bytes_needed(parameters.size) << " bytes for the room" << std::endl;
+            allocated_room = std::make_unique<Grid>(parameters.size);
+        }
+    } catch(const std::bad_alloc& ba) {
+        std::cerr << ba.what() << ": not enough memory for a room that big" << std::endl;
+        return 1;
+    }
+    Grid& room = *allocated_room;
+    room.set_flood_threads(std::thread::hardware_concurrency());
+    // only measured when asked for, written out when the game ends or the process gets a signal
+    Game_Metrics metrics;
+    if(!parameters.metrics.empty()) {
+        if(export_metrics(parameters.metrics.c_str()))
+            room.set_metrics(&metrics);
+        else
+            std::cerr << parameters.metrics << ": can't write metrics there, not measuring anything" << std::endl;
+    }
+    // every move from here on can be taken back, journals can have undos in them so this goes on before replaying
+    Move_History history;
+    room.set_history(&history);
+    // on a terminal only the cells that changed get redrawn after the first frame, and only what fits on screen
+    Renderer renderer(room, isatty(STDOUT_FILENO));
+    renderer.fit(terminal_size());
+
+    std::cout << "room seed: " << parameters.seed << std::endl;
+    bool seeded = !parameters.load.empty();
+    if(!parameters.replay.empty() || resuming) { // everything in the journal, as fast as it'll go and without drawing
+        auto start = std::chrono::steady_clock::now();
+        std::int64_t replayed = replay(reader, room, parameters.frequency, parameters.seed,
+                                       resuming ? -1 : parameters.replay_moves);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "replayed " << replayed << " moves in " << seconds << " s" << std::endl;
+        if(replayed > 0)
+            std::cout << "3BV: " << room.minimum_clicks() << " (" << room.openings() << " openings)" << std::endl;
+        seeded = replayed > 0;
+        room.forget_changes();
+    }
+    if(!parameters.replay.empty() || room.won() || room.lost()) { // only wanted to see it, or there's nothing to play
+        renderer.draw();
+        if(!parameters.save.empty() && room.save(parameters.save))
+            std::cout << "saved to " << parameters.save << std::endl;
+        if(room.won())
+            std::cout << "the world thanks you!" << std::endl;
+        else if(room.lost())
+            std::cout << "their wicked breath haunts you" << std::endl;
+        return 0;
+    }
+    Move_Journal journal;
+    if(!parameters.journal.empty()) {
+        if(!parameters.load.empty())
+            std::cerr << "a journal has to start from a new room, not recording this one" << std::endl;
+        else if(resuming ? journal.resume(parameters.journal, reader.length(), reader.last(), parameters.seed)
+                         : journal.create(parameters.journal, parameters))
+            room.set_journal(&journal);
+    }
+
+    if(!parameters.script.empty()) { // nobody's at the keyboard, play the moves back to back
+        Move_Script script;
+        if(!script.open(parameters.script.c_str())) {
+            std::cerr << parameters.script << ": can't read the script" << std::endl;
+            return 1;
+        }
+        play_script(room, renderer, script, parameters, seeded);
+        if(!parameters.save.empty() && room.save(parameters.save))
+            std::cout << "saved to " << parameters.save << std::endl;
+    } else {
+        renderer.draw();
+        room.forget_changes();
+        if(!seeded) {
+            // the room gets laid out while the player decides where to start, so all that's left after they do is
+            // moving whatever's in the way, the frame above is the last thing to look at the room until then
+            std::unique_ptr<No_Guess_Pool> pool;
+            std::thread generating;
+            if(parameters.no_guess) {
+                pool = std::make_unique<No_Guess_Pool>(std::thread::hardware_concurrency());
+                pool->stock(parameters.size, parameters.frequency, parameters.seed);
+            } else
+                generating = std::thread([&]() { room.generate(parameters.frequency, parameters.seed); });
+            Coordinates avoid = user_choice(parameters.size);
+            if(parameters.no_guess) {
+                pool->stop(); // nothing else is coming, and a board that fits this click is all that's wanted
+                if(seed_without_guessing(room, avoid, parameters.frequency, parameters.seed,
+                                         std::thread::hardware_concurrency(), pool.get()))
+                    std::cout << "no guessing needed, room seed: " << room.random_seed() << std::endl;
+            } else {
+                generating.join();
+                room.open_start(avoid);
+            }
+            renderer.focus(avoid);
+            renderer.draw();
+            room.forget_changes();
+        }
+        if(room.metrics())
+            publish_metrics(metrics);
+
+        Coordinates choice;
+        while(!room.won()) {
+            char action = choose_action(renderer.scrolls(), !parameters.save.empty(), true);
+            if(action == 'q') {
+                journal.flush();
+                if(!room.save(parameters.save))
+                    continue;
+                std::cout << "saved to " << parameters.save << ", --load it to carry on" << std::endl;
+                return 0;
+            } else if(action == 'f') {
+                choice = user_choice(parameters.size);
+                renderer.focus(choice);
+                room.flag(choice);
+            } else if(action == 's') {
+                choice = user_choice(parameters.size);
+                renderer.focus(choice);
+                room.select(choice);
+            } else if(action == 'u' || action == 'r') {
+                if((action == 'u' ? room.undo() : room.redo()) == 0)
+                    std::cout << "nothing to " << (action == 'u' ? "undo" : "redo") << std::endl;
+            } else { // look around
+                renderer.scroll(action == 'h' ? -1 : action == 'l' ? 1 : 0,
+                                action == 'k' ? 1 : action == 'j' ? -1 : 0);
             }
+            renderer.draw();
+            room.forget_changes();
+            if(room.lost()) { // gross, shared space with a mouthbreather, a select or a redo of one
+                if(!wants_to_take_back())
+                    break;
+                room.undo();
+                renderer.draw();
+                room.forget_changes();
+            }
+            journal.flush();
+            if(room.metrics())
+                publish_metrics(metrics);
         }
-        room.display();
     }
-    if(room.number_selected() == number_of_selectable_cells) // won
-    {
+    if(room.metrics()) {
+        publish_metrics(metrics);
+        write_metrics();
+    }
+    if(room.won()) {
         std::cout << "the world thanks you!" << std::endl;
     } else { // lost
         std::cout << "their wicked breath haunts you" << std::endl;
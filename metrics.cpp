@@ -0,0 +1,166 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+// two copies of the JSON, a signal handler only ever reads the one published points at while the other is
+// being rebuilt, so it never sees half of a snapshot
+std::string snapshots[2];
+std::atomic<int> published = -1;
+int metrics_file = -1;
+
+// the parts of writing that are safe inside a signal handler, nothing here allocates or takes a lock
+void write_snapshot()
+{
+    int which = published.load();
+    if(metrics_file < 0 || which < 0)
+        return;
+    const std::string& json = snapshots[which];
+    if(ftruncate(metrics_file, 0) != 0)
+        return;
+    std::size_t written = 0;
+    while(written < json.size()) {
+        ssize_t result = pwrite(metrics_file, json.data() + written, json.size() - written, off_t(written));
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+            return;
+        written += std::size_t(result);
+    }
+}
+
+void on_signal(int signal)
+{
+    int saved_errno = errno;
+    write_snapshot();
+    if(signal != SIGUSR1)
+        _exit(128 + signal);
+    errno = saved_errno;
+}
+
+void append_number(std::string& out, const char* format, double value)
+{
+    char number[32];
+    int length = std::snprintf(number, sizeof(number), format, value);
+    out.append(number, std::size_t(std::max(length, 0)));
+}
+
+void append_integer(std::string& out, std::int64_t value)
+{
+    out += std::to_string(value);
+}
+
+void append_timing(std::string& out, const char* name, const Call_Timing& timing)
+{
+    out += '"';
+    out += name;
+    out += "\": {\"calls\": ";
+    append_integer(out, timing.calls);
+    out += ", \"seconds\": ";
+    append_number(out, "%.9g", timing.seconds);
+    out += ", \"slowest\": ";
+    append_number(out, "%.9g", timing.slowest);
+    out += '}';
+}
+} // namespace
+
+// keep the move if it's one of the slowest so far
+void mouthbreather::Game_Metrics::add_move(const Move_Metrics& move)
+{
+    cells_revealed += move.revealed;
+    most_revealed = std::max(most_revealed, move.revealed);
+    if(slowest_moves.size() == SLOWEST_MOVES_KEPT_ && slowest_moves.back().seconds >= move.seconds)
+        return;
+    auto slower = [](const Move_Metrics& a, const Move_Metrics& b) { return a.seconds > b.seconds; };
+    slowest_moves.insert(std::upper_bound(slowest_moves.begin(), slowest_moves.end(), move, slower), move);
+    if(slowest_moves.size() > SLOWEST_MOVES_KEPT_)
+        slowest_moves.pop_back();
+}
+
+// the whole thing as one JSON object
+void mouthbreather::Game_Metrics::write_json(std::string& out) const
+{
+    out.clear();
+    out += "{\"width\": ";
+    append_integer(out, width);
+    out += ", \"height\": ";
+    append_integer(out, height);
+    out += ", \"frequency\": ";
+    append_number(out, "%g", frequency);
+    out += ", \"seed\": ";
+    out += std::to_string(seed);
+    out += ", \"mouthbreathers\": ";
+    append_integer(out, mouthbreathers);
+    out += ",\n \"cells_revealed\": ";
+    append_integer(out, cells_revealed);
+    out += ", \"most_revealed\": ";
+    append_integer(out, most_revealed);
+    out += ", \"deepest_flood\": ";
+    append_integer(out, deepest_flood);
+    out += ", \"buffer_growths\": ";
+    append_integer(out, buffer_growths);
+    out += ", \"bytes_displayed\": ";
+    append_integer(out, bytes_displayed);
+    out += ",\n \"timings\": {";
+    append_timing(out, "seed", seeding);
+    out += ", ";
+    append_timing(out, "select", select);
+    out += ", ";
+    append_timing(out, "auto_clear", auto_clear);
+    out += ", ";
+    append_timing(out, "display", display);
+    out += "},\n \"slowest_moves\": [";
+    for(std::size_t move = 0; move < slowest_moves.size(); ++move) {
+        const Move_Metrics& slow = slowest_moves[move];
+        out += move ? ",\n  {\"x\": " : "\n  {\"x\": ";
+        append_integer(out, slow.x);
+        out += ", \"y\": ";
+        append_integer(out, slow.y);
+        out += ", \"seconds\": ";
+        append_number(out, "%.9g", slow.seconds);
+        out += ", \"revealed\": ";
+        append_integer(out, slow.revealed);
+        out += ", \"flood_depth\": ";
+        append_integer(out, slow.flood_depth);
+        out += '}';
+    }
+    out += "]}\n";
+}
+
+// open the file up front, a signal handler can't
+bool mouthbreather::export_metrics(const char* path)
+{
+    metrics_file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(metrics_file < 0)
+        return false;
+    struct sigaction action = {};
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    return true;
+}
+
+// rebuild the copy no signal handler can be looking at, then point at it
+void mouthbreather::publish_metrics(const Game_Metrics& metrics)
+{
+    int next = published.load() == 0 ? 1 : 0;
+    metrics.write_json(snapshots[next]);
+    published.store(next);
+}
+
+// write whatever was last published to the file
+void mouthbreather::write_metrics()
+{
+    write_snapshot();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mouthbreather
+{
+constexpr std::size_t SLOWEST_MOVES_KEPT_ = 16;
+
+// how often something was called and how long it took
+struct Call_Timing {
+    std::int64_t calls = 0;
+    double seconds = 0;
+    double slowest = 0;
+
+    void add(double elapsed)
+    {
+        ++calls;
+        seconds += elapsed;
+        slowest = std::max(slowest, elapsed);
+    }
+};
+
+// one select, so a slow one can be matched up with what it did
+struct Move_Metrics {
+    int x = 0;
+    int y = 0;
+    double seconds = 0;
+    std::int64_t revealed = 0;    // including everything the flood fill opened up
+    std::int64_t flood_depth = 0; // the most cells the flood fill had waiting to be looked around at once
+};
+
+// everything measured over one game, a Grid only fills this in when it's been given one with set_metrics()
+struct Game_Metrics {
+    int width = 0;
+    int height = 0;
+    float frequency = 0;
+    std::uint64_t seed = 0;
+    std::int64_t mouthbreathers = 0;
+
+    Call_Timing seeding;
+    Call_Timing select;
+    Call_Timing auto_clear;
+    Call_Timing display; // Grid::display and every Renderer frame
+    std::int64_t cells_revealed = 0;
+    std::int64_t most_revealed = 0; // by one select
+    std::int64_t deepest_flood = 0;
+    std::int64_t buffer_growths = 0; // times the flood fill queue or the change list had to reallocate
+    std::int64_t bytes_displayed = 0;
+    std::vector<Move_Metrics> slowest_moves; // slowest first, at most SLOWEST_MOVES_KEPT_ of them
+
+    void add_move(const Move_Metrics& move);
+    // the whole thing as one JSON object, replacing whatever was in out
+    void write_json(std::string& out) const;
+};
+
+// adds the time until it goes out of scope to timing, or does nothing at all if timing is null, which is what keeps
+// the cost near zero when nobody asked for metrics
+class Scoped_Timer
+{
+    using Clock = std::chrono::steady_clock;
+    Call_Timing* _timing;
+    Clock::time_point _start;
+
+public:
+    explicit Scoped_Timer(Call_Timing* timing)
+        : _timing(timing)
+    {
+        if(_timing)
+            _start = Clock::now();
+    }
+    ~Scoped_Timer()
+    {
+        if(_timing)
+            _timing->add(elapsed());
+    }
+    double elapsed() { return std::chrono::duration<double>(Clock::now() - _start).count(); }
+};
+
+// write the metrics to path when the game ends, when the process gets SIGUSR1, or when it's interrupted or
+// terminated (SIGINT, SIGTERM), false if the file can't be opened
+// only one game's metrics can be exported at a time
+bool export_metrics(const char* path);
+// hand over the latest numbers, call this after every move so a signal has something recent to write
+void publish_metrics(const Game_Metrics& metrics);
+// write whatever was last published to the file
+void write_metrics();
+} // namespace mouthbreather
@@ -1,14 +1,35 @@
 #include "mouthbreather.hpp"
+#include "history.hpp"
+#include "journal.hpp"
+#include "metrics.hpp"
+#include <charconv>
 
 using namespace mouthbreather;
 
+namespace
+{
+// the whole of text as a seed, false for anything that isn't one, negatives and anything past 2^64 - 1 included
+bool parse_seed(std::string_view text, std::uint64_t& seed)
+{
+    std::uint64_t parsed = 0;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    if(text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size())
+        return false;
+    seed = parsed;
+    return true;
+}
+} // namespace
+
 // convert command line arguments into game parameters
 Game_Parameters mouthbreather::get_parameters(int& number_of_arguments, char** arguments)
 {
     Game_Parameters parameters;
 
-    if(number_of_arguments != 3 &&
-       number_of_arguments != 4) // improper cl arguments, or none specified, either way: defaults
+    if(number_of_arguments > 1 && arguments[1][0] == '-' && arguments[1][1] == '-')
+        return get_flag_parameters(number_of_arguments, arguments);
+
+    if(number_of_arguments < 3 ||
+       number_of_arguments > 5) // improper cl arguments, or none specified, either way: defaults
     {
         parameters.Default();
         return parameters;
@@ -18,7 +39,7 @@ Game_Parameters mouthbreather::get_parameters(int& number_of_arguments, char** a
     std::string convert{ arguments[1] }; // x
     try {
         parameters.size.x = std::stoi(convert, nullptr);
-    } catch(const std::invalid_argument& ia) {
+    } catch(const std::logic_error& ia) {
         std::cerr << ia.what() << ": cannot convert command line argument to integer" << std::endl;
         parameters.Default();
         return parameters;
@@ -26,7 +47,7 @@ Game_Parameters mouthbreather::get_parameters(int& number_of_arguments, char** a
     convert = arguments[2]; // y
     try {
         parameters.size.y = std::stoi(convert, nullptr);
-    } catch(const std::invalid_argument& ia) {
+    } catch(const std::logic_error& ia) {
         std::cerr << ia.what() << ": cannot convert command line argument to integer" << std::endl;
         parameters.Default();
         return parameters;
@@ -41,11 +62,11 @@ Game_Parameters mouthbreather::get_parameters(int& number_of_arguments, char** a
         parameters.Default();
         return parameters;
     }
-    if(number_of_arguments == 4) {
+    if(number_of_arguments >= 4) {
         convert = arguments[3]; // frequency
         try {
             parameters.frequency = std::stof(convert, nullptr);
-        } catch(const std::invalid_argument& ia) {
+        } catch(const std::logic_error& ia) {
             std::cerr << ia.what() << ": cannot convert command line argument to float" << std::endl;
             parameters.Default();
             return parameters;
@@ -58,20 +79,127 @@ Game_Parameters mouthbreather::get_parameters(int& number_of_arguments, char** a
     } else {
         parameters.frequency = DEFAULT_FREQUENCY_;
     }
+    if(number_of_arguments == 5) {
+        if(!parse_seed(arguments[4], parameters.seed))
+            std::cerr << arguments[4] << ": cannot convert command line argument to a seed, using a random one"
+                      << std::endl;
+    }
     return parameters;
 }
 
+// --size X Y --frequency F --seed S --simulate N --threads T --metrics FILE --script FILE --load FILE --save FILE
+// --journal FILE --replay FILE --moves N --unbounded --serve ADDRESS --no-guess, anything left out keeps its default
+Game_Parameters mouthbreather::get_flag_parameters(int& number_of_arguments, char** arguments)
+{
+    Game_Parameters parameters;
+    parameters.Default();
+
+    for(int i = 1; i < number_of_arguments; ++i) {
+        std::string flag{ arguments[i] };
+        int values = flag == "--size" ? 2 : flag == "--unbounded" || flag == "--no-guess" ? 0 : 1;
+        if(flag != "--size" && flag != "--frequency" && flag != "--seed" && flag != "--simulate" &&
+           flag != "--threads" && flag != "--metrics" && flag != "--script" && flag != "--load" && flag != "--save" &&
+           flag != "--journal" && flag != "--replay" && flag != "--moves" && flag != "--unbounded" &&
+           flag != "--serve" && flag != "--no-guess") {
+            std::cerr << flag << ": unknown option, ignoring it" << std::endl;
+            continue;
+        }
+        if(i + values >= number_of_arguments) {
+            std::cerr << flag << " needs " << values << " value(s) after it" << std::endl;
+            break;
+        }
+        try {
+            if(flag == "--size") {
+                parameters.size.x = std::stoi(arguments[i + 1], nullptr);
+                parameters.size.y = std::stoi(arguments[i + 2], nullptr);
+            } else if(flag == "--frequency") {
+                parameters.frequency = std::stof(arguments[i + 1], nullptr);
+            } else if(flag == "--seed") {
+                if(!parse_seed(arguments[i + 1], parameters.seed))
+                    std::cerr << arguments[i + 1] << ": --seed takes a number from 0 to 2^64 - 1, using a random one"
+                              << std::endl;
+            } else if(flag == "--simulate") {
+                parameters.simulate = std::stoll(arguments[i + 1], nullptr);
+            } else if(flag == "--metrics") {
+                parameters.metrics = arguments[i + 1];
+            } else if(flag == "--script") {
+                parameters.script = arguments[i + 1];
+            } else if(flag == "--load") {
+                parameters.load = arguments[i + 1];
+            } else if(flag == "--save") {
+                parameters.save = arguments[i + 1];
+            } else if(flag == "--journal") {
+                parameters.journal = arguments[i + 1];
+            } else if(flag == "--replay") {
+                parameters.replay = arguments[i + 1];
+            } else if(flag == "--moves") {
+                parameters.replay_moves = std::stoll(arguments[i + 1], nullptr);
+            } else if(flag == "--unbounded") {
+                parameters.unbounded = true;
+            } else if(flag == "--serve") {
+                parameters.serve = arguments[i + 1];
+            } else if(flag == "--no-guess") {
+                parameters.no_guess = true;
+            } else {
+                parameters.threads = std::max(std::stoi(arguments[i + 1], nullptr), 1);
+            }
+        } catch(const std::logic_error& ia) { // invalid_argument or out_of_range
+            std::cerr << ia.what() << ": cannot convert the value of " << flag << std::endl;
+        }
+        i += values;
+    }
+
+    if(parameters.size.x > SIZE_LIMIT_ || parameters.size.y > SIZE_LIMIT_) {
+        std::cerr << "parameters passed are too large" << std::endl;
+        parameters.size = Coordinates(DEFAULT_SIZE_, DEFAULT_SIZE_);
+    }
+    if(parameters.size.x < SIZE_MININUM_ || parameters.size.y < SIZE_MININUM_) {
+        std::cerr << "size cannot be smaller than: " << SIZE_MININUM_ << std::endl;
+        parameters.size = Coordinates(DEFAULT_SIZE_, DEFAULT_SIZE_);
+    }
+    if(parameters.frequency > 1 || parameters.frequency <= 0) {
+        std::cerr << "frequency parameter is unacceptable, apply yourself" << std::endl;
+        parameters.frequency = DEFAULT_FREQUENCY_;
+    }
+    return parameters;
+}
+
+// how many bytes the cells of a grid this size take, so a huge room can be reported before it's allocated
+std::int64_t mouthbreather::Grid::bytes_needed(Coordinates size)
+{
+    std::int64_t cells = (std::int64_t(size.x) + 2) * (std::int64_t(size.y) + 2);
+    return cells * std::int64_t(sizeof(Cell)) + 4 * ((cells + 63) / 64 + 1) * std::int64_t(sizeof(std::uint64_t));
+}
+
 // create an indexed uniform grid of cells
-mouthbreather::Grid::Grid(Coordinates size, Cell** grid)
+mouthbreather::Grid::Grid(Coordinates size)
 {
     // set coordinates to real size of the Grid
     Grid::_size = size;
     ++_size.x;
     ++_size.y;
-    Grid::_contents = grid;
+    // one allocation for the whole room, including the index row/column and the border past the far edges
+    Grid::_stride = std::int64_t(_size.x) + 1;
+    Grid::_contents.resize(_stride * (std::int64_t(_size.y) + 1));
+    Grid::_planes = Bit_Board(_contents.size(), _stride);
+    for(int x = 0; x <= _size.x; ++x) {
+        _planes.revealed.set(x);
+        _planes.revealed.set(std::int64_t(_size.y) * _stride + x);
+    }
+    for(int y = 0; y <= _size.y; ++y) {
+        _planes.revealed.set(std::int64_t(y) * _stride);
+        _planes.revealed.set(std::int64_t(y) * _stride + _size.x);
+    }
+    for(std::int64_t y = 1; y < _size.y; ++y) {
+        for(std::int64_t i = y * _stride + 1; i < y * _stride + _size.x; ++i)
+            _planes.playable.set(i);
+    }
+    // left, left and above, above, right and above, right, right and below, below, left and below
+    std::int64_t offsets[8] = { -1, _stride - 1, _stride, _stride + 1, 1, 1 - _stride, -_stride, -1 - _stride };
+    std::copy(offsets, offsets + 8, _neighbor_offsets);
 
     // how many characters wide the cell will be
-    int cell_width = 1;
+    std::size_t cell_width = 1;
     int power_of_ten = 10;
     while(power_of_ten <= Grid::_size.x || power_of_ten <= Grid::_size.y) {
         power_of_ten = power_of_ten * 10;
@@ -83,324 +211,267 @@ mouthbreather::Grid::Grid(Coordinates size, Cell** grid)
     display = UNKNOWN_CELL_SYMBOL_;
     if(display.size() > cell_width)
         cell_width = display.size();
-    Grid::_cell_size = cell_width;
-
-    // fill left column with letters
-    for(int i = 1; i < _size.y; ++i) {
-        _contents[0][_size.y - i].display = number_to_letter(i);
-        _contents[0][_size.y - i].display.insert(0, _cell_size - _contents[0][_size.y - i].display.size(),
-                                                 ' '); // pad left side of cell with whitespace
+    Grid::_cell_size = int(cell_width);
+
+    // the text for every state a cell can be in, padded once here instead of every time a cell changes
+    // a flag shows even on a revealed cell, and taking it off shows what's underneath again
+    _glyphs.reserve(std::size_t(Cell::STATES) * _cell_size);
+    for(int bits = 0; bits < Cell::STATES; ++bits) {
+        std::string_view symbol = UNKNOWN_CELL_SYMBOL_;
+        char number[1] = { char('0' + (bits & Cell::COUNT)) };
+        if(bits & Cell::FLAGGED)
+            symbol = WARNING_CELL_SYMBOL_;
+        else if(!(bits & Cell::REVEALED))
+            symbol = UNKNOWN_CELL_SYMBOL_;
+        else if(bits & Cell::MOUTHBREATHER)
+            symbol = MOUTHBREATHER_CELL_SYMBOL_;
+        else if(bits & Cell::COUNT)
+            symbol = std::string_view(number, 1);
+        else
+            symbol = "";
+        _glyphs.append((_cell_size - symbol.size() + 1) / 2, ' '); // padding left
+        _glyphs += symbol;
+        _glyphs.append((_cell_size - symbol.size()) / 2, ' '); // padding right
     }
+}
 
-    // fill origin of cell
-    _contents[0][0].display.insert(0, Grid::_cell_size, ' ');
-
-    // create display-cell contents
-    int padding_right = (_cell_size - display.size()) / 2;
-    int padding_left = ((_cell_size - display.size()) + 1) / 2;
-    display.append(padding_right, ' ');
-    display.insert(0, padding_left, ' ');
-
-    power_of_ten = 10;
-    cell_width = 1;
-
-    for(int x = 1; x < _size.x; ++x) {
-        // fill cells
-        for(int y = 1; y < _size.y; ++y) {
-            _contents[x][y].display = display;
-            _contents[x][y].actual = 0;
-        }
+std::int64_t mouthbreather::Grid::seed(Coordinates& avoid, float& frequency, std::uint64_t random_seed)
+{
+    Scoped_Timer timer(_metrics ? &_metrics->seeding : nullptr);
+    generate(frequency, random_seed);
+    return clear_start(avoid);
+}
 
-        // add the numbers to bottom row for index
-        while(power_of_ten <= x) {
-            power_of_ten = power_of_ten * 10;
-            ++cell_width;
-        }
-        _contents[x][0].display = std::to_string(x);
-        _contents[x][0].display.insert(0, Grid::_cell_size - cell_width, ' '); // pad left side of cell with whitespace
-        _contents[x][0].actual = 0;
-    }
-}
-
-int mouthbreather::Grid::seed(Coordinates& avoid, float& frequency)
-{
-    // init
-    srand(time(nullptr));
-    int size_x = Grid::_size.x - 1;
-    int size_y = Grid::_size.y - 1;
-    int mouthbreather_count = round(double(size_x * size_y) * frequency);
-    Coordinates mouthbreather_locations[mouthbreather_count];
-    // seed grid without duplicates, and not in the squares surrounding the cell the user first selected
-    std::vector<Coordinates> cells_to_avoid = bordering_cells_coordinates(avoid);
-    cells_to_avoid.push_back(avoid);
-
-    for(int i = 0; i < mouthbreather_count; ++i) {
-    try_again:
-        mouthbreather_locations[i].x = (rand() % size_x) + 1;
-        mouthbreather_locations[i].y = (rand() % size_x) + 1;
-        for(int d = i - 1; d >= 0; --d) { // check for duplicates
-            if(mouthbreather_locations[i] == mouthbreather_locations[d]) {
-                goto try_again;
-            }
+// the mouthbreathers go anywhere at all, the starting area gets cleared out of them once the player picks it
+void mouthbreather::Grid::generate(float frequency, std::uint64_t random_seed)
+{
+    Random_Generator random(random_seed);
+    Grid::_random_seed = random_seed;
+    Grid::_frequency = frequency;
+    std::int64_t width = Grid::_size.x - 1;
+    std::int64_t candidates = size();
+    std::int64_t mouthbreather_count = std::clamp<std::int64_t>(llround(double(size()) * frequency), 0, candidates);
+    // one byte per cell laid out just like _contents, so the border is already there for the neighbor count
+    std::vector<std::uint8_t> mouthbreathers(_contents.size(), 0);
+
+    // the n-th cell, left to right from the bottom row
+    auto choose = [&](std::int64_t n) { mouthbreathers[(n / width + 1) * _stride + n % width + 1] = 1; };
+
+    if(mouthbreather_count <= candidates / 16) {
+        // partial Fisher-Yates, only the slots that got swapped are remembered so this is O(mouthbreather_count)
+        std::unordered_map<std::int64_t, std::int64_t> swapped;
+        swapped.reserve(mouthbreather_count);
+        auto slot = [&](std::int64_t n) {
+            auto found = swapped.find(n);
+            return found == swapped.end() ? n : found->second;
+        };
+        for(std::int64_t i = 0; i < mouthbreather_count; ++i) {
+            std::int64_t j = i + std::int64_t(random.below(candidates - i));
+            std::int64_t picked = slot(j);
+            swapped[j] = slot(i);
+            choose(picked);
         }
-        for(std::vector<mouthbreather::Coordinates>::size_type a = 0; a < cells_to_avoid.size();
-            ++a) { // make sure it isn't in the  starting area
-            if(mouthbreather_locations[i] == cells_to_avoid[a]) {
-                goto try_again;
+    } else {
+        // crowded enough that one pass over every candidate is cheaper, each one is picked with probability
+        // (mouthbreathers still needed) / (candidates left), which comes out to exactly mouthbreather_count
+        std::int64_t needed = mouthbreather_count;
+        for(std::int64_t n = 0; needed > 0; ++n) {
+            if(std::int64_t(random.below(candidates - n)) < needed) {
+                choose(n);
+                --needed;
             }
         }
     }
-    for(int i = 0; i < mouthbreather_count; ++i) {
-        _contents[mouthbreather_locations[i].x][mouthbreather_locations[i].y].actual = -1;
-        std::vector<Cell*> bordering_cells = border_cells(mouthbreather_locations[i]);
-        for(auto r : bordering_cells) {
-            if(r->actual != -1)
-                ++r->actual;
+
+    // count every cell's neighbors in one streaming pass instead of bumping the cells around each mouthbreather
+    std::vector<std::uint8_t> counts(_contents.size(), 0);
+    count_neighbors(mouthbreathers.data(), counts.data(), _stride, std::int64_t(_size.y) + 1);
+    for(std::int64_t y = 1; y < _size.y; ++y) {
+        for(std::int64_t i = y * _stride + 1; i < y * _stride + _size.x; ++i) {
+            _contents[i].bits = mouthbreathers[i] ? Cell::MOUTHBREATHER : counts[i];
+            if(mouthbreathers[i])
+                _planes.mouthbreathers.set(i);
         }
     }
+    Grid::_mouthbreather_count = mouthbreather_count;
+    _openings.build(_planes);
+}
 
-    for(std::vector<mouthbreather::Coordinates>::size_type i = 0; i < cells_to_avoid.size();
-        ++i) // clear the starting place for the player
-    {
-        select(cells_to_avoid[i]);
-    }
-    return mouthbreather_count;
+std::int64_t mouthbreather::Grid::open_start(Coordinates& avoid)
+{
+    Scoped_Timer timer(_metrics ? &_metrics->seeding : nullptr);
+    return clear_start(avoid);
 }
 
-// returns all the cells surrounding a cell at specified coordinates
-std::vector<Cell*> mouthbreather::Grid::border_cells(Coordinates& cell_coordinates)
+// every mouthbreather in the starting area moves somewhere random outside it, and only the counts around where it
+// left and where it went get looked at again, so this costs the same whatever size the room is
+// the moves come from their own stream off the room's seed, so the same seed and start always give the same room
+std::int64_t mouthbreather::Grid::clear_start(Coordinates& avoid)
 {
-    std::vector<Cell*> bordering_cells;
-    if(cell_coordinates.x == 1) // left edge
-    {
-        if(cell_coordinates.y == Grid::_size.y - 1) // top left corner
-        {
-            bordering_cells.reserve(3);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]); // below
-            bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]); // to the right
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x + 1][cell_coordinates.y - 1]); // to the right and below
-        } else if(cell_coordinates.y == 1)                                   // bottom left corner
-        {
-            bordering_cells.reserve(3);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]); // above
-            bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]); // to the right
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x + 1][cell_coordinates.y + 1]); // to the right and above
-        } else {
-            bordering_cells.reserve(5);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]); // above
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x + 1][cell_coordinates.y + 1]);                   // to the right and above
-            bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]); // to the right
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x + 1][cell_coordinates.y - 1]);                   // to the right and below
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]); // below
+    // the journal only needs where the room was seeded around, not the selects that open it up, and opening it up
+    // isn't a move anyone can take back
+    Move_Journal* journal = std::exchange(_journal, nullptr);
+    Move_History* history = std::exchange(_history, nullptr);
+    if(journal)
+        journal->record_seed(avoid, _random_seed);
+    Random_Generator random(_random_seed ^ 0xa0761d6478bd642f);
+
+    // not in the squares surrounding the cell the user first selected, there's never more than 9 of them
+    std::int64_t cells_to_avoid[9];
+    std::int64_t avoided = 0;
+    auto avoid_cell = [&](std::int64_t index) {
+        if(playable(index))
+            cells_to_avoid[avoided++] = index;
+    };
+    if(in_bounds(avoid)) {
+        avoid_cell(index_of(avoid));
+        for_each_neighbor(index_of(avoid), avoid_cell);
+    }
+    auto in_start = [&](std::int64_t index) {
+        return std::find(cells_to_avoid, cells_to_avoid + avoided, index) != cells_to_avoid + avoided;
+    };
+    auto free_cell = [&](std::int64_t index) { return !_planes.mouthbreathers.test(index) && !in_start(index); };
+
+    // where the moved ones came from and went to, every count that needs patching is next to one of them
+    std::int64_t moved[18];
+    std::int64_t touched = 0;
+    std::int64_t width = Grid::_size.x - 1;
+    auto nth = [&](std::int64_t n) { return (n / width + 1) * _stride + n % width + 1; }; // same order as generate
+    for(std::int64_t i = 0; i < avoided; ++i) {
+        std::int64_t from = cells_to_avoid[i];
+        if(!_planes.mouthbreathers.test(from))
+            continue;
+        _planes.mouthbreathers.reset(from);
+        moved[touched++] = from;
+        // a few random tries find a free cell unless the room is nearly full, then look along from the last one
+        std::int64_t n = std::int64_t(random.below(size()));
+        for(int attempt = 1; attempt < 64 && !free_cell(nth(n)); ++attempt)
+            n = std::int64_t(random.below(size()));
+        std::int64_t step = 0;
+        while(step < size() && !free_cell(nth((n + step) % size())))
+            ++step;
+        if(step == size()) { // nowhere left to go
+            --_mouthbreather_count;
+            continue;
         }
-    } else if(cell_coordinates.x == Grid::_size.x - 1) // right edge
-    {
-        if(cell_coordinates.y == Grid::_size.y - 1) // top right corner
-        {
-            bordering_cells.reserve(3);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]); // below
-            bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]); // to the left
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x - 1][cell_coordinates.y - 1]); // to the left and below
-        } else if(cell_coordinates.y == 1)                                   // bottom right corner
-        {
-            bordering_cells.reserve(3);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]); // above
-            bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]); // to the left
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x - 1][cell_coordinates.y + 1]); // to the left and above
-        } else {
-            bordering_cells.reserve(5);
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]); // above
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x - 1][cell_coordinates.y + 1]);                   // to the left and above
-            bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]); // to the left
-            bordering_cells.push_back(
-                &_contents[cell_coordinates.x - 1][cell_coordinates.y - 1]);                   // to the left and below
-            bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]); // below
+        std::int64_t to = nth((n + step) % size());
+        _planes.mouthbreathers.set(to);
+        moved[touched++] = to;
+    }
+    auto recount = [&](std::int64_t index) {
+        if(!playable(index))
+            return;
+        if(_planes.mouthbreathers.test(index)) {
+            _contents[index].bits = Cell::MOUTHBREATHER;
+            return;
         }
-    } else if(cell_coordinates.y == 1) // bottom edge
-    {
-        bordering_cells.reserve(5);
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]);     // to the left
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y + 1]); // to the left and above
-        bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]);     // above
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y + 1]); // to the right and above
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]);     // to the right
-
-    } else if(cell_coordinates.y == _size.y - 1) // top edge
-    {
-        bordering_cells.reserve(5);
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]);     // to the left
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y - 1]); // to the left and below
-        bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]);     // below
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y - 1]); // to the right and below
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]);     // to the right
-
-    } else if(cell_coordinates.x < _size.x - 1 && cell_coordinates.x >= 1 && cell_coordinates.y < _size.y - 1 &&
-              cell_coordinates.y >= 1) // all around + check to make sure the coordinate is even in bounds of the array
+        std::uint8_t count = 0;
+        for_each_neighbor(index, [&](std::int64_t neighbor) { count += _planes.mouthbreathers.test(neighbor); });
+        _contents[index].bits = count;
+    };
+    for(std::int64_t i = 0; i < touched; ++i) {
+        recount(moved[i]);
+        for_each_neighbor(moved[i], recount);
+        // the openings around here aren't what they were, selecting in them floods like it used to
+        _openings.invalidate_around(moved[i]);
+        for_each_neighbor(moved[i], [&](std::int64_t neighbor) { _openings.invalidate_around(neighbor); });
+    }
+
+    for(std::int64_t i = 0; i < avoided; ++i) // clear the starting place for the player
     {
-        bordering_cells.reserve(8);
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y]);     // to the left
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y + 1]); // to the left and above
-        bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y + 1]);     // above
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y + 1]); // to the right and above
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y]);     // to the right
-        bordering_cells.push_back(&_contents[cell_coordinates.x + 1][cell_coordinates.y - 1]); // to the right and below
-        bordering_cells.push_back(&_contents[cell_coordinates.x][cell_coordinates.y - 1]);     // below
-        bordering_cells.push_back(&_contents[cell_coordinates.x - 1][cell_coordinates.y - 1]); // to the left and below
+        Coordinates cell = coordinates_of(cells_to_avoid[i]);
+        select(cell);
     }
-    return bordering_cells;
+    _journal = journal;
+    _history = history;
+    if(_metrics)
+        record_room_metrics();
+    return _mouthbreather_count;
 }
 
-std::vector<Coordinates> mouthbreather::Grid::bordering_cells_coordinates(Coordinates& cell_coordinates)
+void mouthbreather::Grid::record_room_metrics()
 {
-    std::vector<Coordinates> bordering_coordinates;
-    if(cell_coordinates.x == 1) // left edge
-    {
-        if(cell_coordinates.y == Grid::_size.y - 1) // top left corner
-        {
-            bordering_coordinates.reserve(3);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x + 1, cell_coordinates.y - 1)); // to the right and below
-        }
-        if(cell_coordinates.y == 1) // bottom left corner
-        {
-            bordering_coordinates.reserve(3);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x + 1, cell_coordinates.y + 1)); // to the right and above
-        } else {
-            bordering_coordinates.reserve(5);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x + 1, cell_coordinates.y + 1)); // to the right and above
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x + 1, cell_coordinates.y - 1)); // to the right and below
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-        }
-    } else if(cell_coordinates.x == Grid::_size.x - 1) // right edge
-    {
-        if(cell_coordinates.y == Grid::_size.y - 1) // top right corner
-        {
-            bordering_coordinates.reserve(3);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x - 1, cell_coordinates.y - 1)); // to the left and below
-        }
-        if(cell_coordinates.y == 1) // bottom right corner
-        {
-            bordering_coordinates.reserve(3);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x - 1, cell_coordinates.y + 1)); // to the left and above
-        } else {
-            bordering_coordinates.reserve(5);
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x - 1, cell_coordinates.y + 1)); // to the left and above
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-            bordering_coordinates.push_back(
-                Coordinates(cell_coordinates.x - 1, cell_coordinates.y - 1)); // to the left and below
-            bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-        }
-    } else if(cell_coordinates.y == 1) // bottom edge
-    {
-        bordering_coordinates.reserve(5);
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x - 1, cell_coordinates.y + 1)); // to the left and above
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x + 1, cell_coordinates.y + 1)); // to the right and above
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-
-    } else if(cell_coordinates.y == _size.y - 1) // top edge
-    {
-        bordering_coordinates.reserve(5);
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x - 1, cell_coordinates.y - 1)); // to the left and below
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x + 1, cell_coordinates.y - 1)); // to the right and below
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-
-    } else if(in_bounds(cell_coordinates)) // all around + check to make sure the coordinate is even in bounds of
-                                           // the array
-    {
-        bordering_coordinates.reserve(8);
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x - 1, cell_coordinates.y)); // to the left
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x - 1, cell_coordinates.y + 1)); // to the left and above
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y + 1)); // above
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x + 1, cell_coordinates.y + 1)); // to the right and above
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x + 1, cell_coordinates.y)); // to the right
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x + 1, cell_coordinates.y - 1)); // to the right and below
-        bordering_coordinates.push_back(Coordinates(cell_coordinates.x, cell_coordinates.y - 1)); // below
-        bordering_coordinates.push_back(
-            Coordinates(cell_coordinates.x - 1, cell_coordinates.y - 1)); // to the left and below
-    }
-    return bordering_coordinates;
+    _metrics->width = _size.x - 1;
+    _metrics->height = _size.y - 1;
+    _metrics->frequency = _frequency;
+    _metrics->seed = _random_seed;
+    _metrics->mouthbreathers = _mouthbreather_count;
+}
+
+void mouthbreather::Grid::set_metrics(Game_Metrics* metrics)
+{
+    _metrics = metrics;
+    if(_metrics && _mouthbreather_count > 0) // a loaded room never gets seeded, so nothing else would say what it is
+        record_room_metrics();
 }
 
 // print the grid to console
+// the whole frame is built in _frame first and written with one call, instead of a stream insertion per cell and a
+// flush per row
 void mouthbreather::Grid::display()
 {
-    for(int y = 1; y <= _size.y; ++y) {
-        for(int x = 0; x < _size.x; ++x) {
-            std::cout << _contents[x][_size.y - y].display << "|";
-            //<< _contents[x][_size.y - y].actual
+    Scoped_Timer timer(_metrics ? &_metrics->display : nullptr);
+    _frame.clear();
+    _frame.reserve(frame_size());
+    render(_frame);
+    std::cout.flush(); // anything already printed has to come out first
+    std::fwrite(_frame.data(), 1, _frame.size(), stdout);
+    std::fflush(stdout);
+    if(_metrics)
+        _metrics->bytes_displayed += std::int64_t(_frame.size());
+}
+
+// add a window of the grid to the end of frame, top row first, with its own index column and row
+void mouthbreather::Grid::render(std::string& frame, Coordinates corner, Coordinates cells)
+{
+    for(int y = corner.y + cells.y - 1; y >= corner.y; --y) {
+        std::string label = number_to_letter(_size.y - y);
+        frame.append(_cell_size - label.size(), ' '); // pad left side of cell with whitespace
+        frame += label;
+        frame += '|';
+        for(int x = corner.x; x < corner.x + cells.x; ++x) {
+            frame += cell_text(std::int64_t(y) * _stride + x);
+            frame += '|';
         }
-        std::cout << std::endl;
+        frame += '\n';
+    }
+
+    // numbers along the bottom
+    frame.append(_cell_size, ' ');
+    frame += '|';
+    for(int x = corner.x; x < corner.x + cells.x; ++x) {
+        std::string label = std::to_string(x);
+        frame.append(_cell_size - label.size(), ' ');
+        frame += label;
+        frame += '|';
     }
+    frame += '\n';
 }
 
 // convert a number to a Spreadsheet like index
 std::string mouthbreather::number_to_letter(int number)
 {
+    // bijective base 26, A to Z then AA, AB... so every row gets its own label
     std::string letters;
-    int power_of_26 = 26;
-    while(power_of_26 < number) {
-        power_of_26 = power_of_26 * 26;
-    }
-    power_of_26 = power_of_26 / 26;
-    int digit = number / power_of_26;    // base 26 digit
-    while(digit * power_of_26 != number) // there is a remainder
-    {
-        letters += char(digit + 64); // ascii transform base 26 to letters
-        number = number - (digit * power_of_26);
-        power_of_26 = power_of_26 / 26;
-        digit = number / power_of_26;
-    }
-    letters += char(digit + 64);
+    for(; number > 0; number = (number - 1) / 26)
+        letters.insert(letters.begin(), char('A' + (number - 1) % 26));
     return letters;
 }
 
-// convert a Spreadsheet like index to a number
-int mouthbreather::letter_to_number(std::string letter)
+// convert a Spreadsheet like index to a number, A is 0, -1 if it isn't one
+int mouthbreather::letter_to_number(std::string_view letter)
 {
-    int number = 0;
-    int size = letter.size();
-    for(int check = 0; check < size; ++check) {
-        if(letter[check] < 65 || letter[check] > 90) {
+    if(letter.empty())
+        return -1;
+    std::int64_t number = 0;
+    for(char digit : letter) {
+        if(digit < 'A' || digit > 'Z')
+            return -1;
+        number = number * 26 + (digit - 'A' + 1);
+        if(number > SIZE_LIMIT_)
             return -1;
-        }
-        number += pow((letter[check] - 65), size - check);
     }
-    return number;
+    return int(number - 1);
 }
 
 Coordinates mouthbreather::user_choice(Coordinates& size)
@@ -437,91 +508,356 @@ try_again:
 
 // if user wants to select a cell or flag it as containing a gross mouthbreather
 bool mouthbreather::wants_to_flag()
+{
+    return choose_action(false) == 'f';
+}
+
+// if user wants to take back the select that just lost
+bool mouthbreather::wants_to_take_back()
 {
     std::string buffer;
+    std::cout << "take it back (y/n)? " << std::flush;
+    std::cin >> buffer;
+    return buffer == "y";
+}
+
+// flag, select, or when the room is bigger than the screen, move the view around, undo or redo, or save and stop
+char mouthbreather::choose_action(bool can_scroll, bool can_save, bool can_undo)
+{
+    // only the choices on offer get listed, with an or before the last one
+    std::vector<const char*> choices = { "flag (f)", "select (s)" };
+    if(can_scroll)
+        choices.push_back("look around (h j k l)");
+    if(can_undo) {
+        choices.push_back("undo (u)");
+        choices.push_back("redo (r)");
+    }
+    if(can_save)
+        choices.push_back("save and quit (q)");
+    std::string prompt;
+    for(std::size_t i = 0; i < choices.size(); ++i)
+        prompt.append(i == 0 ? "" : i + 1 == choices.size() ? " or " : ", ").append(choices[i]);
+    prompt += "? ";
+
+    std::string buffer;
 try_again:
-    std::cout << "flag (f) or select (s)? " << std::flush;
+    std::cout << prompt << std::flush;
     std::cin >> buffer;
-    if(buffer == "f") {
-        return true;
-    } else if(buffer == "s") {
-        return false;
+    if(buffer == "f" || buffer == "s") {
+        return buffer[0];
+    } else if(can_scroll && (buffer == "h" || buffer == "j" || buffer == "k" || buffer == "l")) {
+        return buffer[0];
+    } else if(can_undo && (buffer == "u" || buffer == "r")) {
+        return buffer[0];
+    } else if(can_save && buffer == "q") {
+        return buffer[0];
     }
     std::cout << "\ninvalid choice, try again" << std::endl;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(),
-                    '\n'); // i usually accidently type in the coordinates, TODO make it automatically select the
-                           // coordinates, unless prefixed with an f ( f 5 6, for flag, else 5 6)
+    // most likely coordinates typed without the action in front, the action and the cell can go on one line already
+    // ("s 5 C" or "f 5 C"), so throw the rest of this one away rather than read it as more choices
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     goto try_again;
 }
 
 bool mouthbreather::Grid::select(Coordinates& cell_coordinates)
 {
+    Scoped_Timer timer(_metrics ? &_metrics->select : nullptr);
+    if(_journal)
+        _journal->record_select(cell_coordinates);
+    _last_revealed = 0;
+    _last_flood_depth = 0;
+    std::int64_t position = change_position();
+    std::int64_t selected_before = total_cells_selected;
     if(in_bounds(cell_coordinates)) {
-        Cell* selection = get_cell(cell_coordinates);
-        if(!selection->selected) {
-            ++total_cells_selected;
-            selection->selected = true;
-            if(selection->actual == -1) {
-                selection->display = MOUTHBREATHER_CELL_SYMBOL_;
-                selection->display.append((_cell_size - selection->display.size()) / 2, ' ');          // padding right
-                selection->display.insert(0, ((_cell_size - selection->display.size()) + 1) / 2, ' '); // padding left
-                return false;
-            } else if(selection->actual == 0) {
-                auto_clear(cell_coordinates, selection);
-            } else {
-                selection->display = char(selection->actual + 48);
-                // int padding_right = (Grid::_cell_size - 1) / 2;
-                // int padding_left = ((Grid::_cell_size - 1) + 1) / 2;
-                selection->display.append((_cell_size - 1) / 2, ' ');          // padding right
-                selection->display.insert(0, ((_cell_size - 1) + 1) / 2, ' '); // padding left
+        std::int64_t index = index_of(cell_coordinates);
+        if(_planes.revealed.claim(index)) {
+            Cell& selection = _contents[index];
+            std::size_t frontier_capacity = _frontier.capacity();
+            std::size_t changes_capacity = _changes.capacity();
+            reveal(index);
+            _changes.push_back(index);
+            _last_revealed = 1;
+            if(selection.actual() == 0)
+                _last_revealed += auto_clear(index);
+            total_cells_selected += _last_revealed;
+            if(_history)
+                _history->record(false, changes_since(position), _contents.data(), selected_before,
+                                 total_cells_selected, _planes);
+            if(_metrics) {
+                _metrics->buffer_growths += (_frontier.capacity() != frontier_capacity) +
+                                            (_changes.capacity() != changes_capacity);
+                _metrics->add_move(Move_Metrics{ cell_coordinates.x, cell_coordinates.y, timer.elapsed(),
+                                                 _last_revealed, _last_flood_depth });
             }
+            if(selection.actual() == -1)
+                return false;
         }
     }
     return true;
 }
 
+// show what's in a cell
+void mouthbreather::Grid::reveal(std::int64_t index)
+{
+    _planes.flagged.reset_atomic(index); // auto_clear can reveal from more than one thread
+    Cell& selection = _contents[index];
+    selection.bits = std::uint8_t((selection.bits | Cell::REVEALED) & ~Cell::FLAGGED);
+}
+
 // mark a cell as a mouthbreather
 void mouthbreather::Grid::flag(Coordinates& cell_coordinates)
 {
-    // TODO if you unflag a cell that has already been selected, it will show it as a mystery, and you can't unselect it
+    if(_journal)
+        _journal->record_flag(cell_coordinates);
     if(in_bounds(cell_coordinates)) {
-        Cell* selection = get_cell(cell_coordinates);
-        if(selection->display.find(WARNING_CELL_SYMBOL_) != std::string::npos) // unflag
-        {
-            selection->display = UNKNOWN_CELL_SYMBOL_;
-            // int padding_right = (Grid::_cell_size - size of unknown cell symbol) / 2;
-            // int padding_left = ((Grid::_cell_size - size of unknown cell symbol) + 1) / 2;
-            selection->display.append((_cell_size - selection->display.size()) / 2, ' ');          // padding right
-            selection->display.insert(0, ((_cell_size - selection->display.size()) + 1) / 2, ' '); // padding left
-
-        } else { // flag
-            selection->display = WARNING_CELL_SYMBOL_;
-            // int padding_right = (Grid::_cell_size - size of warning_cell_symbol) / 2;
-            // int padding_left = ((Grid::_cell_size - size of warning_cell_symbol) + 1) / 2;
-            selection->display.append((_cell_size - selection->display.size()) / 2, ' ');          // padding right
-            selection->display.insert(0, ((_cell_size - selection->display.size()) + 1) / 2, ' '); // padding left
-        }
+        std::int64_t index = index_of(cell_coordinates);
+        _planes.flagged.flip(index);
+        _contents[index].bits ^= Cell::FLAGGED;
+        _changes.push_back(index);
+        if(_history)
+            _history->record(true, std::span<const std::int64_t>(&index, 1), _contents.data(), total_cells_selected,
+                             total_cells_selected, _planes);
+    }
+}
+
+void mouthbreather::Grid::select_many(std::span<Coordinates> locations, Move_Results& results)
+{
+    std::int64_t position = change_position();
+    std::int64_t selected_before = total_cells_selected;
+    bool breathed_on = false;
+    for(Coordinates& location : locations) {
+        breathed_on = !select(location);
+        if(breathed_on)
+            break;
     }
+    describe_changes(position, selected_before, results);
+    results.breathed_on = breathed_on;
+}
+
+void mouthbreather::Grid::flag_many(std::span<Coordinates> locations, Move_Results& results)
+{
+    std::int64_t position = change_position();
+    std::int64_t selected_before = total_cells_selected;
+    for(Coordinates& location : locations)
+        flag(location);
+    describe_changes(position, selected_before, results);
+}
+
+// straight off the change log, sorted so a cell changed more than once is only sent once
+void mouthbreather::Grid::describe_changes(std::int64_t position, std::int64_t selected_before, Move_Results& results)
+{
+    results.changes.clear();
+    for(std::int64_t index : changes_since(position))
+        results.changes.push_back(Cell_Change{ index, 0 });
+    auto by_index = [](const Cell_Change& a, const Cell_Change& b) { return a.index < b.index; };
+    std::sort(results.changes.begin(), results.changes.end(), by_index);
+    auto same = [](const Cell_Change& a, const Cell_Change& b) { return a.index == b.index; };
+    results.changes.erase(std::unique(results.changes.begin(), results.changes.end(), same), results.changes.end());
+    for(Cell_Change& change : results.changes)
+        change.code = code_at(change.index);
+    results.revealed = total_cells_selected - selected_before;
+    results.breathed_on = false;
+    results.cells_selected = total_cells_selected;
 }
 
 Cell* mouthbreather::Grid::get_cell(Coordinates& cell_coordinates)
 {
     if(in_bounds(cell_coordinates))
-        return &_contents[cell_coordinates.x][cell_coordinates.y];
+        return &at(cell_coordinates.x, cell_coordinates.y);
     else
         return nullptr;
 }
 
-void mouthbreather::Grid::auto_clear(Coordinates& cell_coordinates, Cell* selection)
+// clear every cell connected to an empty cell, returns how many were cleared
+// the empty cells still to be looked around are kept in _frontier instead of on the call stack, so the size of an
+// opening is only limited by memory
+std::int64_t mouthbreather::Grid::auto_clear(std::int64_t start)
 {
-    if(in_bounds(cell_coordinates)) {
-        selection->display = " ";
-        selection->display.insert(0, _cell_size - 1, ' '); // pad cells
-        std::vector<Coordinates> surrounding_cells = bordering_cells_coordinates(cell_coordinates);
-        for(std::vector<mouthbreather::Coordinates>::size_type i = 0; i < surrounding_cells.size(); ++i) {
-            select(surrounding_cells[i]);
+    Scoped_Timer timer(_metrics ? &_metrics->auto_clear : nullptr);
+    std::int64_t cleared = 0;
+    _last_flood_depth = 1;
+    std::int64_t opening = _openings.opening_at(start);
+    if(opening >= 0)
+        cleared = reveal_opening(opening); // no frontier to grow, it still counts as a flood of depth 1
+    else {
+        _frontier.clear();
+        _frontier.push_back(start);
+        while(!_frontier.empty()) {
+            _last_flood_depth = std::max(_last_flood_depth, std::int64_t(_frontier.size()));
+            if(_flood_threads > 1 && std::int64_t(_frontier.size()) >= PARALLEL_FLOOD_THRESHOLD_) {
+                cleared += auto_clear_parallel();
+                break;
+            }
+            std::int64_t current = _frontier.back();
+            _frontier.pop_back();
+            for_each_neighbor(current, [&](std::int64_t neighbor) {
+                if(_planes.revealed.claim(neighbor)) {
+                    reveal(neighbor);
+                    _changes.push_back(neighbor);
+                    ++cleared;
+                    if(_contents[neighbor].actual() == 0)
+                        _frontier.push_back(neighbor);
+                }
+            });
+        }
+    }
+    if(_metrics)
+        _metrics->deepest_flood = std::max(_metrics->deepest_flood, _last_flood_depth);
+    return cleared;
+}
+
+// the opening's already been found, so this is just its spans and the rows either side of them, marked revealed 64
+// cells at a time, with only the cells that weren't already looked at one by one
+std::int64_t mouthbreather::Grid::reveal_opening(std::int64_t opening)
+{
+    std::vector<std::uint64_t>& revealed = _planes.revealed.words();
+    std::vector<std::uint64_t>& flagged = _planes.flagged.words();
+    std::int64_t cleared = 0;
+    // [begin, end), the border's always revealed so it never gets in
+    auto reveal_range = [&](std::int64_t begin, std::int64_t end) {
+        for(std::int64_t word = begin >> 6; word <= (end - 1) >> 6; ++word) {
+            std::uint64_t mask = ~std::uint64_t(0);
+            if(word == begin >> 6)
+                mask &= ~std::uint64_t(0) << (begin & 63);
+            if(word == (end - 1) >> 6)
+                mask &= ~std::uint64_t(0) >> (63 - ((end - 1) & 63));
+            std::uint64_t fresh = mask & ~revealed[word];
+            revealed[word] |= fresh;
+            flagged[word] &= ~fresh;
+            for(; fresh; fresh &= fresh - 1) {
+                std::int64_t index = word * 64 + std::countr_zero(fresh);
+                _contents[index].bits = std::uint8_t((_contents[index].bits | Cell::REVEALED) & ~Cell::FLAGGED);
+                _changes.push_back(index);
+                ++cleared;
+            }
+        }
+    };
+    for(const Opening_Index::Span& span : _openings.spans(opening)) {
+        reveal_range(span.begin - _stride - 1, span.end - _stride + 1);
+        reveal_range(span.begin - 1, span.end + 1);
+        reveal_range(span.begin + _stride - 1, span.end + _stride + 1);
+    }
+    return cleared;
+}
+
+std::int64_t mouthbreather::Grid::minimum_clicks()
+{
+    if(_openings.stale())
+        _openings.build(_planes);
+    return _openings.minimum_clicks();
+}
+
+std::int64_t mouthbreather::Grid::openings()
+{
+    if(_openings.stale())
+        _openings.build(_planes);
+    return _openings.openings();
+}
+
+// finish clearing whatever is in _frontier one layer at a time, with each layer split up between the threads
+// a cell is only ever revealed by the thread that won its visited bit, so the threads never touch the same cell
+std::int64_t mouthbreather::Grid::auto_clear_parallel()
+{
+    constexpr std::size_t chunk_size = 256;
+    unsigned threads = _flood_threads;
+    _thread_frontiers.resize(threads);
+    _thread_changes.resize(threads);
+    std::vector<std::int64_t> cleared(threads, 0);
+    std::atomic<std::size_t> next_chunk = 0;
+    bool done = false;
+
+    // runs once every thread has finished a layer, the cells they found become the next layer
+    auto next_layer = [&]() noexcept {
+        _frontier.clear();
+        for(std::vector<std::int64_t>& found : _thread_frontiers) {
+            _frontier.insert(_frontier.end(), found.begin(), found.end());
+            found.clear();
+        }
+        _last_flood_depth = std::max(_last_flood_depth, std::int64_t(_frontier.size()));
+        next_chunk.store(0, std::memory_order_relaxed);
+        done = _frontier.empty();
+    };
+    std::barrier layer_finished(threads, next_layer);
+
+    auto work = [&](unsigned id) {
+        std::vector<std::int64_t>& found = _thread_frontiers[id];
+        std::vector<std::int64_t>& changed = _thread_changes[id];
+        std::int64_t count = 0;
+        while(!done) {
+            std::size_t begin;
+            while((begin = next_chunk.fetch_add(chunk_size, std::memory_order_relaxed)) < _frontier.size()) {
+                std::size_t end = std::min(begin + chunk_size, _frontier.size());
+                for(std::size_t i = begin; i < end; ++i) {
+                    for_each_neighbor(_frontier[i], [&](std::int64_t neighbor) {
+                        if(_planes.revealed.claim_atomic(neighbor)) {
+                            reveal(neighbor);
+                            changed.push_back(neighbor);
+                            ++count;
+                            if(_contents[neighbor].actual() == 0)
+                                found.push_back(neighbor);
+                        }
+                    });
+                }
+            }
+            layer_finished.arrive_and_wait();
         }
+        cleared[id] = count;
+    };
+
+    std::vector<std::thread> workers;
+    for(unsigned id = 1; id < threads; ++id)
+        workers.emplace_back(work, id);
+    work(0);
+    for(std::thread& worker : workers)
+        worker.join();
+
+    std::int64_t total = 0;
+    for(unsigned id = 0; id < threads; ++id) {
+        total += cleared[id];
+        _changes.insert(_changes.end(), _thread_changes[id].begin(), _thread_changes[id].end());
+        _thread_changes[id].clear();
     }
+    return total;
+}
+
+// how many flagged cells touch a cell
+std::int64_t mouthbreather::Grid::flags_around(Coordinates& cell_coordinates)
+{
+    if(!in_bounds(cell_coordinates))
+        return 0;
+    return _planes.around(_planes.flagged, index_of(cell_coordinates));
+}
+
+// how many cells touching a cell haven't been revealed yet
+std::int64_t mouthbreather::Grid::hidden_around(Coordinates& cell_coordinates)
+{
+    if(!in_bounds(cell_coordinates))
+        return 0;
+    return 8 - _planes.around(_planes.revealed, index_of(cell_coordinates));
+}
+
+// how many cells in the rectangle between two corners have been revealed
+std::int64_t mouthbreather::Grid::revealed_in(Coordinates corner, Coordinates opposite_corner)
+{
+    int x_low = std::max(std::min(corner.x, opposite_corner.x), 1);
+    int x_high = std::min(std::max(corner.x, opposite_corner.x), _size.x - 1);
+    int y_low = std::max(std::min(corner.y, opposite_corner.y), 1);
+    int y_high = std::min(std::max(corner.y, opposite_corner.y), _size.y - 1);
+    if(x_low > x_high || y_low > y_high)
+        return 0;
+    return _planes.in_region(_planes.revealed, x_low, y_low, x_high, y_high);
+}
+
+// if every cell in the rectangle between two corners has been revealed
+bool mouthbreather::Grid::region_revealed(Coordinates corner, Coordinates opposite_corner)
+{
+    std::int64_t width = std::min(std::max(corner.x, opposite_corner.x), _size.x - 1) -
+                         std::max(std::min(corner.x, opposite_corner.x), 1) + 1;
+    std::int64_t height = std::min(std::max(corner.y, opposite_corner.y), _size.y - 1) -
+                          std::max(std::min(corner.y, opposite_corner.y), 1) + 1;
+    if(width <= 0 || height <= 0)
+        return true;
+    return revealed_in(corner, opposite_corner) == width * height;
 }
 
 inline bool mouthbreather::Grid::in_bounds(Coordinates& cell_coordinates)
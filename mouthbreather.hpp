@@ -1,19 +1,37 @@
+#pragma once
+#include "bit_board.hpp"
+#include "neighbor_count.hpp"
+#include "opening_index.hpp"
+#include <algorithm>
+#include <atomic>
+#include <barrier>
 #include <cmath>
+#include <cstdint>
+#include <ctime>
 #include <iostream>
+#include <cstdio>
 #include <limits>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace mouthbreather
 {
-constexpr int SIZE_LIMIT_ = 511; // don't want to put a lot on the stack, plus I hear it's good general practice to have
-                                 // hard limits in all of your programs
+constexpr int SIZE_LIMIT_ = 1 << 24; // the room lives on the heap now, so the real limit is how much memory you have,
+                                     // this just keeps every coordinate comfortably inside an int
 constexpr int SIZE_MININUM_ = 5;
 constexpr int DEFAULT_SIZE_ = 5;
 constexpr float DEFAULT_FREQUENCY_ = .2;
 constexpr auto UNKNOWN_CELL_SYMBOL_ = "."; // "\\_(\\\")_/" = \_(\")_/
 constexpr auto MOUTHBREATHER_CELL_SYMBOL_ = ":O";
 constexpr auto WARNING_CELL_SYMBOL_ = "+";
+constexpr std::int64_t PARALLEL_FLOOD_THRESHOLD_ = 1 << 12; // an opening has to be this wide before it's worth
+                                                            // splitting across threads
 
 struct Coordinates {
     Coordinates(){};
@@ -32,9 +50,26 @@ struct Coordinates {
     int y;
 };
 
+struct Game_Metrics;
+class Move_Journal;
+class Move_History;
+
 struct Game_Parameters {
     Coordinates size;
     float frequency;
+    std::uint64_t seed = std::uint64_t(time(nullptr)); // same seed, same room
+    std::int64_t simulate = 0; // how many games to play without anyone watching, 0 to play for real
+    unsigned threads = 1;
+    std::string metrics; // where to write this game's metrics as JSON, empty to not measure anything
+    std::string script;  // moves to play instead of asking for them, - for stdin, empty to play for real
+    std::string load;    // save file to carry on from instead of seeding a new room
+    std::string save;    // where to save the room when the player quits, or when the script runs out
+    std::string journal; // record every move here, and if there's already a game in it, replay it and carry on
+    std::string replay;  // journal to rebuild a room from, without playing
+    std::int64_t replay_moves = -1; // how much of it to replay, -1 for all of it
+    bool unbounded = false; // play in a room with no edges instead, made a chunk at a time as it's explored
+    std::string serve;      // socket path or host:port to host games on instead of playing one, empty to play
+    bool no_guess = false;  // only make rooms the solver can clear from the first click without guessing
     void Default()
     {
         frequency = DEFAULT_FREQUENCY_;
@@ -43,16 +78,91 @@ struct Game_Parameters {
     }
 };
 
+// xoshiro256** (https://prng.di.unimi.it), much faster than rand() and the same numbers everywhere for the same seed
+class Random_Generator
+{
+    std::uint64_t _state[4];
+
+    static std::uint64_t rotate_left(std::uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+public:
+    // spread the seed out with splitmix64 so small seeds like 1, 2, 3 still give unrelated rooms
+    Random_Generator(std::uint64_t seed)
+    {
+        for(std::uint64_t& word : _state) {
+            seed += 0x9e3779b97f4a7c15;
+            std::uint64_t mixed = seed;
+            mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111eb;
+            word = mixed ^ (mixed >> 31);
+        }
+    }
+    std::uint64_t next()
+    {
+        std::uint64_t result = rotate_left(_state[1] * 5, 7) * 9;
+        std::uint64_t shifted = _state[1] << 17;
+        _state[2] ^= _state[0];
+        _state[3] ^= _state[1];
+        _state[1] ^= _state[2];
+        _state[0] ^= _state[3];
+        _state[2] ^= shifted;
+        _state[3] = rotate_left(_state[3], 45);
+        return result;
+    }
+    // uniform number in [0, bound), Lemire's multiply and shift so there's no modulo bias and almost never a division
+    std::uint64_t below(std::uint64_t bound)
+    {
+        unsigned __int128 product = (unsigned __int128)next() * bound;
+        std::uint64_t low = std::uint64_t(product);
+        if(low < bound) {
+            std::uint64_t threshold = -bound % bound;
+            while(low < threshold) {
+                product = (unsigned __int128)next() * bound;
+                low = std::uint64_t(product);
+            }
+        }
+        return std::uint64_t(product >> 64);
+    }
+};
+
+// everything about a cell in one byte, the low 4 bits are how many mouthbreathers touch it
+// what it looks like on screen isn't stored, it's looked up in the Grid's glyph table with the whole byte
 struct Cell {
-    int actual;          // TODO make this an enum (-1 = uh_oh_mouthbreather, or something)
-    std::string display; // this would be more efficient if it was a string pointer, but i don't want to mess around
-                         // with all that
-    bool selected = false;
+    static constexpr std::uint8_t COUNT = 0x0f;
+    static constexpr std::uint8_t MOUTHBREATHER = 0x10;
+    static constexpr std::uint8_t REVEALED = 0x20;
+    static constexpr std::uint8_t FLAGGED = 0x40;
+    static constexpr int STATES = 0x80; // every value bits can have
+
+    std::uint8_t bits = 0;
+
+    // -1 for a mouthbreather, otherwise the count
+    int actual() const { return bits & MOUTHBREATHER ? -1 : bits & COUNT; }
+};
+
+// one cell a batch of moves changed and what it shows now, as Grid::code_at() gives it
+struct Cell_Change {
+    std::int64_t index;
+    char code;
+};
+
+// what a batch of moves did, all at once instead of asking the grid after each one
+struct Move_Results {
+    std::vector<Cell_Change> changes; // every cell the batch touched, once each, lowest index first
+    std::int64_t revealed = 0;        // cells the selects revealed, everything the flood fills opened up included
+    bool breathed_on = false;         // a select found a mouthbreather, and the batch stopped there
+    std::int64_t cells_selected = 0;  // number_selected() after the batch
 };
 
 class Grid
 {
-    Cell** _contents;
+    // every cell in one row-major block, (x, y) lives at y * _stride + x
+    // the index column/row at 0 and an extra column/row past the far edges are never played, they are marked as
+    // revealed so nothing ever tries to clear them
+    std::vector<Cell> _contents;
+    // the text for each Cell::bits value, one after another and all _cell_size wide, padding included
+    std::string _glyphs;
+    std::int64_t _stride;
     /*
      * y
      * |
@@ -63,42 +173,208 @@ class Grid
     Coordinates _size;
     int _cell_size;
 
-    // returns all the cells surrounding a cell at specified coordinates
-    std::vector<Cell*> border_cells(Coordinates& location);
-    std::vector<Coordinates> bordering_cells_coordinates(Coordinates& location);
-    void auto_clear(Coordinates& location, Cell* selection);
+    // mouthbreathers, revealed and flagged cells a bit each, the revealed bit doubles as the flood fill's visited
+    // marker so it never looks at a cell twice
+    Bit_Board _planes;
+    // distance to each of the 8 surrounding cells in _contents, the border means these are always safe to use
+    std::int64_t _neighbor_offsets[8];
+    // work queue for auto_clear, kept between calls so clearing a big opening doesn't hit the allocator every time
+    std::vector<std::int64_t> _frontier;
+    std::vector<std::vector<std::int64_t>> _thread_frontiers;
+    std::vector<std::vector<std::int64_t>> _thread_changes;
+    unsigned _flood_threads = 1;
+    std::int64_t _last_revealed = 0;
+    std::uint64_t _random_seed = 0;
+    float _frequency = 0;
+    std::int64_t _mouthbreather_count = 0;
+    // every opening, built when the mouthbreathers go down so selecting an empty cell doesn't have to flood
+    Opening_Index _openings;
+    // every cell that's looked different since the last forget_changes(), oldest first, so whatever draws the
+    // grid only has to redraw what's new
+    std::vector<std::int64_t> _changes;
+    std::int64_t _changes_forgotten = 0;
+    // what display() builds before writing it out in one go, kept so redrawing doesn't reallocate
+    std::string _frame;
+    Game_Metrics* _metrics = nullptr;
+    Move_Journal* _journal = nullptr;
+    Move_History* _history = nullptr;
+    std::int64_t _last_flood_depth = 0;
+
+    // clear every cell connected to an empty cell, returns how many were cleared
+    std::int64_t auto_clear(std::int64_t start);
+    // reveal everything in one of _openings, returns how many weren't already
+    std::int64_t reveal_opening(std::int64_t opening);
+    std::int64_t auto_clear_parallel();
+    // show what's in a cell
+    void reveal(std::int64_t index);
+    // undo or redo until move number move of the history is the last one in effect (history.cpp)
+    void return_to(std::int64_t move);
+    // the room's size, frequency, seed and mouthbreathers into _metrics
+    void record_room_metrics();
+    // rebuild the cells from the planes a save file brought back (save_file.cpp)
+    void restore(const std::uint64_t* mouthbreathers, const std::uint64_t* revealed, const std::uint64_t* flagged,
+                 std::uint64_t random_seed, float frequency);
 
     // return cell at location
     Cell* get_cell(Coordinates& location);
+    Cell& at(int x, int y) { return _contents[std::int64_t(y) * _stride + x]; }
     inline bool in_bounds(Coordinates& location);
-    int total_cells_selected = 0;
+    // the second half of seed, without timing it
+    std::int64_t clear_start(Coordinates& avoid);
+    std::int64_t total_cells_selected = 0;
 
 public:
     // create an indexed uniform grid of cells
-    Grid(Coordinates size, Cell** grid); // TODO make this a singleton, and call the constructor from the seed function
-    int seed(Coordinates& avoid, float& frequency);
+    Grid(Coordinates size); // TODO make this a singleton, and call the constructor from the seed function
+    // how many bytes the cells of a grid this size take, so a huge room can be reported before it's allocated
+    static std::int64_t bytes_needed(Coordinates size);
+    // place the mouthbreathers anywhere but around avoid, the same random_seed always gives the same room
+    std::int64_t seed(Coordinates& avoid, float& frequency, std::uint64_t random_seed);
+    // the same thing in two halves, so the slow one can run before anyone's picked where to start
+    // generate lays out every mouthbreather and count and can run on another thread as long as nothing else touches
+    // the room until it's done, open_start then moves the few in the way of avoid and opens it up
+    // generate then open_start gives exactly the room seed would
+    void generate(float frequency, std::uint64_t random_seed);
+    std::int64_t open_start(Coordinates& avoid);
+    // write the room to path as a save file (save_file.cpp), false if it couldn't be written
+    bool save(const std::string& path);
+    // a room read back from a save file, null if path couldn't be read or isn't one
+    static std::unique_ptr<Grid> load(const std::string& path);
     // print the grid to console
     void display();
+    // add the whole grid to the end of frame, exactly what display() prints
+    void render(std::string& frame) { render(frame, Coordinates(1, 1), room_size()); }
+    // same thing for just the cells.x by cells.y window with its bottom left cell at corner, the index labels are
+    // made for that window only so the cost doesn't depend on how big the room is
+    void render(std::string& frame, Coordinates corner, Coordinates cells);
+    // how many bytes render() adds for a window that size
+    std::int64_t frame_size(Coordinates cells)
+    {
+        return (std::int64_t(cells.y) + 1) * ((std::int64_t(cells.x) + 1) * (_cell_size + 1) + 1);
+    }
+    std::int64_t frame_size() { return frame_size(room_size()); }
+    // what a cell looks like on screen, always cell_size() characters wide
+    std::string_view cell_text(std::int64_t index)
+    {
+        return std::string_view(_glyphs).substr(std::size_t(_contents[index].bits) * _cell_size, _cell_size);
+    }
+    int cell_size() { return _cell_size; }
+    // the size the room was made with, not counting the index row/column
+    Coordinates room_size() { return Coordinates(_size.x - 1, _size.y - 1); }
+    // changes are numbered from the start of the game, hang on to change_position() to ask what changed since
+    std::int64_t change_position() { return _changes_forgotten + std::int64_t(_changes.size()); }
+    // false if some of the changes since position have been forgotten, and the caller needs to start over
+    bool changes_kept_since(std::int64_t position) { return position >= _changes_forgotten; }
+    // indices of the cells changed since position, oldest first, a cell can show up more than once
+    std::span<const std::int64_t> changes_since(std::int64_t position)
+    {
+        return std::span<const std::int64_t>(_changes).subspan(position - _changes_forgotten);
+    }
+    // drop the change list once everything that reads it has caught up, so it doesn't grow forever
+    void forget_changes()
+    {
+        _changes_forgotten = change_position();
+        _changes.clear();
+    }
     bool select(Coordinates& location);
     // mark a cell as a mouthbreather
     void flag(Coordinates& location);
-    int size() { return (_size.x - 1) * (_size.y - 1); }
-    int number_selected() { return total_cells_selected; }
+    // select or flag every cell in order and say what changed, results is cleared first so its buffers get reused
+    // a batch of selects stops at the first mouthbreather
+    void select_many(std::span<Coordinates> locations, Move_Results& results);
+    void flag_many(std::span<Coordinates> locations, Move_Results& results);
+    // what's changed since position (see change_position()), for moves that weren't made through a batch
+    // selected_before is number_selected() from when position was taken, revealed is counted from it
+    void describe_changes(std::int64_t position, std::int64_t selected_before, Move_Results& results);
+    // what a cell shows, in one character: 0-8, * for a mouthbreather, + for a flag or . for hidden
+    char code_at(std::int64_t index)
+    {
+        std::uint8_t bits = _contents[index].bits;
+        if(bits & Cell::FLAGGED)
+            return '+';
+        if(!(bits & Cell::REVEALED))
+            return '.';
+        return bits & Cell::MOUTHBREATHER ? '*' : char('0' + (bits & Cell::COUNT));
+    }
+    std::int64_t size() { return std::int64_t(_size.x - 1) * (_size.y - 1); }
+    std::int64_t number_selected() { return total_cells_selected; }
+    std::int64_t number_of_mouthbreathers() { return _mouthbreather_count; }
+    std::uint64_t random_seed() { return _random_seed; }
+    float frequency() { return _frequency; }
+    // how many cells the last select cleared, including everything auto_clear opened up
+    std::int64_t last_revealed() { return _last_revealed; }
+    // where a cell lives in the grid's storage and back, every per-cell query below is keyed on this index
+    std::int64_t index_of(Coordinates& location) { return std::int64_t(location.y) * _stride + location.x; }
+    Coordinates coordinates_of(std::int64_t index) { return Coordinates(int(index % _stride), int(index / _stride)); }
+    // false for the index row/column and the border around the room
+    bool playable(std::int64_t index) { return _planes.playable.test(index); }
+    // the number showing on a revealed cell, -1 if it isn't showing one (still hidden, or a mouthbreather)
+    int number_at(std::int64_t index)
+    {
+        return _planes.playable.test(index) && _planes.revealed.test(index) ? _contents[index].actual() : -1;
+    }
+    // call visit(neighbor_index) for each of the 8 cells around a playable cell, without allocating anything
+    // cells on the edge of the room get border cells as neighbors instead of special cases, check playable()
+    // (or the revealed plane, where the border is always set) if that matters
+    template<typename Visitor> void for_each_neighbor(std::int64_t index, Visitor&& visit)
+    {
+        for(std::int64_t offset : _neighbor_offsets)
+            visit(index + offset);
+    }
+    // how many flagged or still hidden cells touch a cell, straight off the bit planes
+    std::int64_t flags_around(Coordinates& location);
+    std::int64_t hidden_around(Coordinates& location);
+    // how many cells in the rectangle between two corners have been revealed, and if that's all of them
+    std::int64_t revealed_in(Coordinates corner, Coordinates opposite_corner);
+    bool region_revealed(Coordinates corner, Coordinates opposite_corner);
+    // the room's 3BV, the fewest selects that clear it without flagging anything, and how many openings it has
+    // free once it's seeded, unless clearing the start moved mouthbreathers and the index needs building again
+    std::int64_t minimum_clicks();
+    std::int64_t openings();
+    // every cell without a mouthbreather has been selected
+    bool won() { return _planes.cleared(); }
+    // somebody selected a mouthbreather
+    bool lost() { return _planes.breathed_on(); }
+    const Bit_Board& planes() { return _planes; }
+    // let auto_clear split really big openings across this many threads, 1 keeps it single threaded
+    void set_flood_threads(unsigned threads) { _flood_threads = threads > 0 ? threads : 1; }
+    // time seed, select, auto_clear and display and count what they do into metrics, null to stop
+    // a room that's already laid out (a loaded one) has its size, frequency and seed written into metrics right away
+    void set_metrics(Game_Metrics* metrics);
+    Game_Metrics* metrics() { return _metrics; }
+    // record every seed, select and flag into journal from now on, null to stop
+    void set_journal(Move_Journal* journal) { _journal = journal; }
+    // keep every select and flag from now on in history so they can be undone, null to stop (history.cpp)
+    void set_history(Move_History* history);
+    // take back up to moves of the selects and flags kept in the history, or put back ones that were taken back,
+    // returns how many were, what it costs depends on how many cells those moves changed and not on the room
+    std::int64_t undo(std::int64_t moves = 1);
+    std::int64_t redo(std::int64_t moves = 1);
 };
 
 // convert command line arguments into game parameters
+// either x y [frequency [seed]], or --size X Y --frequency F --seed S --simulate N --threads T --metrics FILE
+// --script FILE --load FILE --save FILE --journal FILE --replay FILE --moves N --unbounded --serve ADDRESS
+// --no-guess in any order
 Game_Parameters get_parameters(int& number_of_arguments, char** arguments);
+Game_Parameters get_flag_parameters(int& number_of_arguments, char** arguments);
 
 // convert a number to a Spreadsheet like index
 std::string number_to_letter(int number);
 
 // convert a Spreadsheet like index to a number
-int letter_to_number(std::string letter);
+int letter_to_number(std::string_view letter);
 
 Coordinates user_choice(Coordinates& size);
 
 // if the user wants to
 bool wants_to_flag();
+// if the user wants to take back the select that just lost the game
+bool wants_to_take_back();
+
+// what the user wants to do next, f (flag) or s (select), if can_scroll is set h/j/k/l to move the view
+// left/down/up/right, if can_undo is set u/r to undo or redo, and if can_save is set q to save and quit
+char choose_action(bool can_scroll, bool can_save = false, bool can_undo = false);
 
 inline void increment(Cell& c);
 
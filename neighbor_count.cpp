@@ -0,0 +1,128 @@
+#include "neighbor_count.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MOUTHBREATHER_X86_
+#endif
+
+using namespace mouthbreather;
+
+namespace
+{
+using Count_Function = void (*)(const std::uint8_t*, std::uint8_t*, std::int64_t, std::int64_t);
+
+// one cell the slow way, also used for whatever is left over at the end of a row
+inline std::uint8_t box_sum(const std::uint8_t* above, const std::uint8_t* row, const std::uint8_t* below,
+                            std::int64_t x)
+{
+    return above[x - 1] + above[x] + above[x + 1] + row[x - 1] + row[x + 1] + below[x - 1] + below[x] + below[x + 1];
+}
+
+void count_scalar(const std::uint8_t* mines, std::uint8_t* counts, std::int64_t stride, std::int64_t rows)
+{
+    for(std::int64_t y = 1; y < rows - 1; ++y) {
+        const std::uint8_t* above = mines + (y + 1) * stride;
+        const std::uint8_t* row = mines + y * stride;
+        const std::uint8_t* below = mines + (y - 1) * stride;
+        std::uint8_t* out = counts + y * stride;
+        for(std::int64_t x = 1; x < stride - 1; ++x)
+            out[x] = box_sum(above, row, below, x);
+    }
+}
+
+#ifdef MOUTHBREATHER_X86_
+__attribute__((target("sse2"))) inline __m128i load16(const std::uint8_t* at)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(at));
+}
+
+__attribute__((target("avx2"))) inline __m256i load32(const std::uint8_t* at)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(at));
+}
+
+// 16 cells at a time, counts never go past 8 so plain byte adds can't overflow
+__attribute__((target("sse2"))) void count_sse2(const std::uint8_t* mines, std::uint8_t* counts,
+                                                std::int64_t stride, std::int64_t rows)
+{
+    for(std::int64_t y = 1; y < rows - 1; ++y) {
+        const std::uint8_t* above = mines + (y + 1) * stride;
+        const std::uint8_t* row = mines + y * stride;
+        const std::uint8_t* below = mines + (y - 1) * stride;
+        std::uint8_t* out = counts + y * stride;
+        std::int64_t x = 1;
+        for(; x + 16 <= stride - 1; x += 16) {
+            __m128i sum = _mm_add_epi8(load16(above + x - 1), load16(above + x));
+            sum = _mm_add_epi8(sum, load16(above + x + 1));
+            sum = _mm_add_epi8(sum, load16(row + x - 1));
+            sum = _mm_add_epi8(sum, load16(row + x + 1));
+            sum = _mm_add_epi8(sum, load16(below + x - 1));
+            sum = _mm_add_epi8(sum, load16(below + x));
+            sum = _mm_add_epi8(sum, load16(below + x + 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), sum);
+        }
+        for(; x < stride - 1; ++x)
+            out[x] = box_sum(above, row, below, x);
+    }
+}
+
+// same as the sse2 version, 32 cells at a time
+__attribute__((target("avx2"))) void count_avx2(const std::uint8_t* mines, std::uint8_t* counts,
+                                                std::int64_t stride, std::int64_t rows)
+{
+    for(std::int64_t y = 1; y < rows - 1; ++y) {
+        const std::uint8_t* above = mines + (y + 1) * stride;
+        const std::uint8_t* row = mines + y * stride;
+        const std::uint8_t* below = mines + (y - 1) * stride;
+        std::uint8_t* out = counts + y * stride;
+        std::int64_t x = 1;
+        for(; x + 32 <= stride - 1; x += 32) {
+            __m256i sum = _mm256_add_epi8(load32(above + x - 1), load32(above + x));
+            sum = _mm256_add_epi8(sum, load32(above + x + 1));
+            sum = _mm256_add_epi8(sum, load32(row + x - 1));
+            sum = _mm256_add_epi8(sum, load32(row + x + 1));
+            sum = _mm256_add_epi8(sum, load32(below + x - 1));
+            sum = _mm256_add_epi8(sum, load32(below + x));
+            sum = _mm256_add_epi8(sum, load32(below + x + 1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), sum);
+        }
+        for(; x < stride - 1; ++x)
+            out[x] = box_sum(above, row, below, x);
+    }
+}
+#endif
+
+struct Kernel {
+    Count_Function function;
+    const char* name;
+};
+
+Kernel pick_kernel()
+{
+#ifdef MOUTHBREATHER_X86_
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return { count_avx2, "avx2" };
+    if(__builtin_cpu_supports("sse2"))
+        return { count_sse2, "sse2" };
+#endif
+    return { count_scalar, "scalar" };
+}
+
+const Kernel& kernel()
+{
+    static const Kernel picked = pick_kernel();
+    return picked;
+}
+} // namespace
+
+void mouthbreather::count_neighbors(const std::uint8_t* mines, std::uint8_t* counts, std::int64_t stride,
+                                    std::int64_t rows)
+{
+    kernel().function(mines, counts, stride, rows);
+}
+
+const char* mouthbreather::neighbor_count_kernel()
+{
+    return kernel().name;
+}
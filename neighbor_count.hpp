@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+namespace mouthbreather
+{
+// add up the 8 cells surrounding every cell of a byte plane, 3x3 box sum minus the middle
+// both planes are rows x stride, row-major, and the first/last row and column of mines must be zero,
+// only the cells inside that border get written to counts
+// picks the widest instruction set the cpu has the first time it's called (avx2, sse2, then plain loops)
+void count_neighbors(const std::uint8_t* mines, std::uint8_t* counts, std::int64_t stride, std::int64_t rows);
+
+// name of the version count_neighbors is using, for benchmarks and bug reports
+const char* neighbor_count_kernel();
+} // namespace mouthbreather
@@ -0,0 +1,204 @@
+#include "no_guess.hpp"
+#include "solver.hpp"
+
+using namespace mouthbreather;
+
+// the solver only ever selects what it can prove is safe, so getting stuck before the room is clear means the player
+// would have had to guess there
+bool mouthbreather::solvable_without_guessing(Coordinates size, Coordinates start, float frequency,
+                                              std::uint64_t random_seed, std::vector<std::int64_t>* opening)
+{
+    Grid room(size);
+    room.seed(start, frequency, random_seed);
+    if(opening) {
+        opening->clear();
+        for(int y = 1; y <= size.y; ++y) {
+            for(int x = 1; x <= size.x; ++x) {
+                Coordinates cell(x, y);
+                std::int64_t index = room.index_of(cell);
+                if(room.number_at(index) == 0)
+                    opening->push_back(index);
+            }
+        }
+    }
+    Solver solver(room);
+    while(!room.won()) {
+        solver.update();
+        std::int64_t index = solver.next_safe();
+        if(index < 0)
+            return false;
+        Coordinates choice = room.coordinates_of(index);
+        room.select(choice);
+    }
+    return true;
+}
+
+// candidate 0 is random_seed itself, so a room that was fine to begin with doesn't change
+std::uint64_t mouthbreather::candidate_seed(std::uint64_t random_seed, std::int64_t attempt)
+{
+    if(attempt == 0)
+        return random_seed;
+    std::uint64_t mixed = random_seed + std::uint64_t(attempt) * 0x9e3779b97f4a7c15;
+    mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9;
+    mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111eb;
+    return mixed ^ (mixed >> 31);
+}
+
+// once a candidate passes, nobody starts one numbered higher, and a thread that finds one stops since everything
+// it'd take next is numbered higher still
+bool mouthbreather::find_no_guess_board(Coordinates size, Coordinates start, float frequency,
+                                        std::uint64_t random_seed, unsigned threads, No_Guess_Board& board,
+                                        std::int64_t limit, const std::atomic<bool>* stop)
+{
+    threads = std::max(threads, 1u);
+    std::atomic<std::int64_t> next_attempt = 0;
+    std::atomic<std::int64_t> best = limit;
+    // what each thread found, so the winner's opening doesn't have to be worked out again
+    std::vector<std::int64_t> found(threads, limit);
+    std::vector<std::vector<std::int64_t>> openings(threads);
+
+    auto work = [&](unsigned id) {
+        for(std::int64_t attempt = next_attempt++; attempt < best.load(std::memory_order_relaxed);
+            attempt = next_attempt++) {
+            if(stop && stop->load(std::memory_order_relaxed))
+                return;
+            if(!solvable_without_guessing(size, start, frequency, candidate_seed(random_seed, attempt), &openings[id]))
+                continue;
+            found[id] = attempt;
+            std::int64_t seen = best.load();
+            while(attempt < seen && !best.compare_exchange_weak(seen, attempt)) {
+            }
+            return;
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned id = 1; id < threads; ++id)
+        workers.emplace_back(work, id);
+    work(0);
+    for(std::thread& worker : workers)
+        worker.join();
+
+    for(unsigned id = 0; id < threads; ++id) {
+        if(found[id] < limit && found[id] == best.load()) {
+            board.random_seed = candidate_seed(random_seed, found[id]);
+            board.start = start;
+            board.opening = std::move(openings[id]);
+            return true;
+        }
+    }
+    return false;
+}
+
+mouthbreather::No_Guess_Pool::No_Guess_Pool(unsigned threads, std::size_t depth)
+    : _depth(depth)
+    , _threads(threads > 0 ? threads : 1)
+{
+    _filler = std::thread(&No_Guess_Pool::fill, this);
+}
+
+mouthbreather::No_Guess_Pool::~No_Guess_Pool()
+{
+    stop();
+}
+
+void mouthbreather::No_Guess_Pool::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+    }
+    _cancel = true;
+    _wanted.notify_all();
+    if(_filler.joinable())
+        _filler.join();
+}
+
+void mouthbreather::No_Guess_Pool::stock(Coordinates size, float frequency, std::uint64_t random_seed)
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        for(Shelf& shelf : _shelves) {
+            if(shelf.size == size && shelf.frequency == frequency)
+                return;
+        }
+        _shelves.push_back(Shelf{ size, frequency, Random_Generator(random_seed), {} });
+    }
+    _wanted.notify_all();
+}
+
+bool mouthbreather::No_Guess_Pool::take(Coordinates size, float frequency, Coordinates click, No_Guess_Board& board)
+{
+    std::int64_t index = std::int64_t(click.y) * (size.x + 2) + click.x; // same stride as the Grid it'll go in
+    std::lock_guard<std::mutex> guard(_lock);
+    for(Shelf& shelf : _shelves) {
+        if(shelf.size != size || shelf.frequency != frequency)
+            continue;
+        for(std::size_t i = 0; i < shelf.boards.size(); ++i) {
+            std::vector<std::int64_t>& opening = shelf.boards[i].opening;
+            if(!std::binary_search(opening.begin(), opening.end(), index))
+                continue;
+            board = std::move(shelf.boards[i]);
+            shelf.boards.erase(shelf.boards.begin() + std::ptrdiff_t(i));
+            _wanted.notify_all();
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+// one board at a time for whichever shelf is shortest, looked for without holding the lock
+// every board starts somewhere random so between them their openings cover as much of the room as they can
+void mouthbreather::No_Guess_Pool::fill()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    for(;;) {
+        Shelf* shortest = nullptr;
+        _wanted.wait(guard, [&]() {
+            shortest = nullptr;
+            for(Shelf& shelf : _shelves) {
+                if(shelf.boards.size() < _depth && (!shortest || shelf.boards.size() < shortest->boards.size()))
+                    shortest = &shelf;
+            }
+            return _stop || shortest;
+        });
+        if(_stop)
+            return;
+        Coordinates size = shortest->size;
+        float frequency = shortest->frequency;
+        Coordinates start(int(shortest->random.below(size.x)) + 1, int(shortest->random.below(size.y)) + 1);
+        std::uint64_t random_seed = shortest->random.next();
+
+        guard.unlock();
+        No_Guess_Board board;
+        bool found = find_no_guess_board(size, start, frequency, random_seed, _threads, board,
+                                         NO_GUESS_ATTEMPT_LIMIT_, &_cancel);
+        guard.lock();
+        if(!found) // found just as it was stopped is still found, and can still be taken
+            continue;
+        for(Shelf& shelf : _shelves) { // shelves can be added while it looks, so shortest may not point at it now
+            if(shelf.size == size && shelf.frequency == frequency)
+                shelf.boards.push_back(std::move(board));
+        }
+    }
+}
+
+bool mouthbreather::seed_without_guessing(Grid& room, Coordinates& click, float frequency, std::uint64_t random_seed,
+                                          unsigned threads, No_Guess_Pool* pool)
+{
+    Coordinates size = room.room_size();
+    No_Guess_Board board;
+    if(pool && pool->take(size, frequency, click, board)) {
+        // click is in the board's opening, so it's already revealed and selecting it after does nothing
+        room.seed(board.start, frequency, board.random_seed);
+        return true;
+    }
+    if(!find_no_guess_board(size, click, frequency, random_seed, threads, board)) {
+        std::cerr << "no room the solver could clear without guessing in " << NO_GUESS_ATTEMPT_LIMIT_
+                  << " tries, this one might need a guess" << std::endl;
+        room.seed(click, frequency, random_seed);
+        return false;
+    }
+    room.seed(click, frequency, board.random_seed);
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "mouthbreather.hpp"
+#include <condition_variable>
+#include <mutex>
+
+namespace mouthbreather
+{
+constexpr std::int64_t NO_GUESS_ATTEMPT_LIMIT_ = 1 << 12; // candidates tried before settling for an ordinary room
+constexpr std::size_t NO_GUESS_POOL_DEPTH_ = 16;          // boards a pool keeps ready for each size and frequency
+
+// a room the solver can clear from its first click without ever guessing
+struct No_Guess_Board {
+    std::uint64_t random_seed = 0; // give Grid::seed this and start to get the room back
+    Coordinates start = Coordinates(0, 0);
+    std::vector<std::int64_t> opening; // grid indices of the empty cells the first click opens up, sorted
+};
+
+// seed a room of that size around start and let the solver play it, true if it won without running out of cells it
+// could prove safe, opening gets the empty cells the first click opened up
+bool solvable_without_guessing(Coordinates size, Coordinates start, float frequency, std::uint64_t random_seed,
+                               std::vector<std::int64_t>* opening = nullptr);
+
+// the random seed candidate number attempt tries, spread out from random_seed so neighboring seeds don't overlap
+std::uint64_t candidate_seed(std::uint64_t random_seed, std::int64_t attempt);
+
+// try candidate rooms around start on this many threads at once until one can be cleared without guessing
+// threads take the next candidate number as they finish one, and the lowest numbered candidate that passes wins, so
+// the same arguments find the same board no matter how many threads look or which one finishes first
+// false if none of the first limit candidates pass, or stop got set, which is checked between candidates
+bool find_no_guess_board(Coordinates size, Coordinates start, float frequency, std::uint64_t random_seed,
+                         unsigned threads, No_Guess_Board& board, std::int64_t limit = NO_GUESS_ATTEMPT_LIMIT_,
+                         const std::atomic<bool>* stop = nullptr);
+
+// boards that have already passed, kept topped up by a thread in the background so a first click doesn't wait on
+// rooms that fail
+// a board only fits a click that lands in its opening, selecting anywhere in there opens up the same cells
+class No_Guess_Pool
+{
+    struct Shelf {
+        Coordinates size;
+        float frequency;
+        Random_Generator random; // where the boards on this shelf start, and the seeds they're looked for from
+        std::vector<No_Guess_Board> boards;
+    };
+    std::mutex _lock;
+    std::condition_variable _wanted; // a shelf is short or it's time to stop
+    std::vector<Shelf> _shelves;
+    std::size_t _depth;
+    unsigned _threads;
+    bool _stop = false;
+    std::atomic<bool> _cancel = false; // the same as _stop, for the search the filler's in the middle of
+    std::thread _filler;
+
+    void fill();
+
+public:
+    // look for boards on this many threads, keeping up to depth of them for every size and frequency
+    No_Guess_Pool(unsigned threads, std::size_t depth = NO_GUESS_POOL_DEPTH_);
+    No_Guess_Pool(const No_Guess_Pool&) = delete;
+    No_Guess_Pool& operator=(const No_Guess_Pool&) = delete;
+    ~No_Guess_Pool();
+
+    // stop looking for boards, giving up on the one being looked for, the ones already found can still be taken
+    // a game with only one room to seed calls this once the click's in, so the filler isn't using the cores the
+    // search on the spot needs
+    void stop();
+    // start keeping boards of this size and frequency on hand
+    void stock(Coordinates size, float frequency, std::uint64_t random_seed);
+    // a board of this size and frequency with click in its opening, false if there isn't one ready
+    bool take(Coordinates size, float frequency, Coordinates click, No_Guess_Board& board);
+};
+
+// seed room around click with a board that can be cleared without guessing, out of pool if it has one that fits and
+// otherwise looked for on threads threads starting from random_seed
+// false if nothing passed and it fell back to an ordinary room from random_seed, which might need a guess
+// room.random_seed() says which seed the room was made from either way
+bool seed_without_guessing(Grid& room, Coordinates& click, float frequency, std::uint64_t random_seed,
+                           unsigned threads, No_Guess_Pool* pool = nullptr);
+} // namespace mouthbreather
@@ -0,0 +1,122 @@
+#include "opening_index.hpp"
+#include <algorithm>
+
+using namespace mouthbreather;
+
+namespace
+{
+std::int64_t find_root(std::vector<std::int64_t>& parent, std::int64_t label)
+{
+    while(parent[label] != label) {
+        parent[label] = parent[parent[label]]; // halve the path on the way up
+        label = parent[label];
+    }
+    return label;
+}
+} // namespace
+
+void mouthbreather::Opening_Index::build(const Bit_Board& planes)
+{
+    std::int64_t stride = planes.stride;
+    _stride = stride;
+    // empty cells are the playable ones with no mouthbreather on or around them, 64 at a time
+    Bit_Plane empty = planes.playable;
+    empty.and_not(planes.mouthbreathers);
+    empty.and_not(planes.surrounding(planes.mouthbreathers));
+
+    // runs read straight off the words, a count of trailing zeros for where each starts and of trailing ones for
+    // how long it is, one that reaches the top of a word carries on into the next
+    // they never wrap onto the next row, the border in between is never empty
+    _runs.clear();
+    const std::vector<std::uint64_t>& words = empty.words();
+    for(std::size_t word = 0; word < words.size(); ++word) {
+        for(std::uint64_t bits = words[word]; bits;) {
+            int start = std::countr_zero(bits);
+            std::uint64_t rest = ~(bits >> start);
+            int length = rest ? std::countr_zero(rest) : 64;
+            std::int64_t begin = std::int64_t(word) * 64 + start;
+            if(!_runs.empty() && _runs.back().end == begin)
+                _runs.back().end += length;
+            else
+                _runs.push_back(Run{ begin, begin + length, 0 });
+            bits = start + length == 64 ? 0 : bits & (~std::uint64_t(0) << (start + length));
+        }
+    }
+
+    std::int64_t rows = (std::int64_t(words.size()) * 64 + stride - 1) / stride;
+    _row_first.assign(rows + 1, std::int64_t(_runs.size()));
+    for(std::int64_t run = std::int64_t(_runs.size()) - 1; run >= 0; --run)
+        _row_first[_runs[run].begin / stride] = run;
+    for(std::int64_t row = rows - 1; row >= 0; --row)
+        _row_first[row] = std::min(_row_first[row], _row_first[row + 1]);
+
+    // a run is in the same opening as any run in the row before that overlaps it, or would if it was one cell longer
+    // at each end, the runs are in index order so the first one that could is only ever further along
+    std::vector<std::int64_t> parent(_runs.size());
+    std::int64_t before = 0;
+    for(std::int64_t run = 0; run < std::int64_t(_runs.size()); ++run) {
+        parent[run] = run;
+        std::int64_t low = _runs[run].begin - stride - 1;
+        std::int64_t high = _runs[run].end - stride + 1;
+        while(before < run && _runs[before].end <= low)
+            ++before;
+        for(std::int64_t other = before; other < run && _runs[other].begin < high; ++other) {
+            std::int64_t a = find_root(parent, run);
+            std::int64_t b = find_root(parent, other);
+            if(a != b)
+                parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+    // number the openings 0 up in order of their lowest run, which is always the root
+    std::int64_t openings = 0;
+    for(std::int64_t run = 0; run < std::int64_t(_runs.size()); ++run) {
+        std::int64_t root = find_root(parent, run);
+        _runs[run].opening = root == run ? openings++ : _runs[root].opening;
+    }
+
+    // group the runs by opening
+    _first.assign(std::size_t(openings) + 1, 0);
+    for(const Run& run : _runs)
+        ++_first[run.opening + 1];
+    for(std::int64_t opening = 0; opening < openings; ++opening)
+        _first[opening + 1] += _first[opening];
+    _spans.resize(_runs.size());
+    std::vector<std::int64_t> next(_first.begin(), _first.end() - 1);
+    for(const Run& run : _runs)
+        _spans[next[run.opening]++] = Span{ run.begin, run.end };
+
+    // everything that isn't a mouthbreather and doesn't touch an empty cell takes a select of its own
+    Bit_Plane isolated = planes.playable;
+    isolated.and_not(planes.mouthbreathers);
+    isolated.and_not(empty);
+    isolated.and_not(planes.surrounding(empty));
+    _isolated = isolated.count();
+    _stale.assign(openings, 0);
+    _any_stale = false;
+}
+
+// only the runs in index's row have to be searched
+std::int64_t mouthbreather::Opening_Index::run_at(std::int64_t index) const
+{
+    std::int64_t row = index / std::max<std::int64_t>(_stride, 1);
+    if(index < 0 || row + 1 >= std::int64_t(_row_first.size()))
+        return -1;
+    auto first = _runs.begin() + _row_first[row];
+    auto after = std::upper_bound(first, _runs.begin() + _row_first[row + 1], index,
+                                  [](std::int64_t cell, const Run& run) { return cell < run.begin; });
+    if(after == first || (after - 1)->end <= index)
+        return -1;
+    return (after - 1) - _runs.begin();
+}
+
+void mouthbreather::Opening_Index::invalidate_around(std::int64_t index)
+{
+    _any_stale = true; // even with no opening here, one might have just been made
+    for(std::int64_t row = index - _stride; row <= index + _stride; row += _stride) {
+        for(std::int64_t cell = row - 1; cell <= row + 1; ++cell) {
+            std::int64_t run = run_at(cell);
+            if(run >= 0)
+                _stale[_runs[run].opening] = 1;
+        }
+    }
+}
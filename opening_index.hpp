@@ -0,0 +1,66 @@
+#pragma once
+#include "bit_board.hpp"
+#include <span>
+
+namespace mouthbreather
+{
+// every opening in a room, worked out once the mouthbreathers are down so selecting an empty cell can reveal its
+// whole opening from a list instead of flooding out to find it
+// an opening is a connected patch of empty cells plus the numbered cells around its edge, a numbered cell on the
+// edge of two openings is in both
+// it's kept as runs of empty cells along a row rather than cell by cell, so it's labeled a run at a time and costs
+// nothing per cell once it's built
+class Opening_Index
+{
+public:
+    // empty cells [begin, end) of one row
+    struct Span {
+        std::int64_t begin;
+        std::int64_t end;
+    };
+
+private:
+    struct Run {
+        std::int64_t begin;
+        std::int64_t end;
+        std::int64_t opening;
+    };
+    std::int64_t _stride = 0;
+    std::vector<Run> _runs;           // every run of empty cells in the room, lowest index first
+    std::vector<std::int64_t> _row_first; // the first run in each row, plus one past the last row
+    std::vector<std::int64_t> _first; // where each opening's spans start in _spans, plus one past the last
+    std::vector<Span> _spans;         // every opening's runs, lowest index first
+    std::vector<std::uint8_t> _stale; // openings the layout has changed under since build
+    bool _any_stale = false;
+    std::int64_t _isolated = 0; // numbered cells that aren't on the edge of any opening
+
+    // the run index is in, -1 if it isn't in one
+    std::int64_t run_at(std::int64_t index) const;
+
+public:
+    Opening_Index(){};
+
+    // find the runs of empty cells and join up the ones that touch with a union-find pass, O(cells / 64 + runs)
+    // the planes only have to have the mouthbreathers and playable cells in them
+    void build(const Bit_Board& planes);
+    // the opening an empty cell is in, -1 if it isn't empty or its opening can't be trusted anymore
+    std::int64_t opening_at(std::int64_t index) const
+    {
+        std::int64_t run = run_at(index);
+        return run < 0 || _stale[_runs[run].opening] ? -1 : _runs[run].opening;
+    }
+    // the empty cells of an opening, the numbered cells on its edge are whatever touches them
+    std::span<const Span> spans(std::int64_t opening) const
+    {
+        return std::span<const Span>(_spans.data() + _first[opening], _spans.data() + _first[opening + 1]);
+    }
+    // index is about to change between a mouthbreather and not, or its count is, so any opening it or a neighbor
+    // is part of might grow, shrink or split
+    void invalidate_around(std::int64_t index);
+    // something was invalidated, so openings() and minimum_clicks() are out of date until the next build
+    bool stale() const { return _any_stale; }
+    std::int64_t openings() const { return std::int64_t(_stale.size()); }
+    // the 3BV, the fewest selects that clear the room: one per opening and one per numbered cell outside them
+    std::int64_t minimum_clicks() const { return openings() + _isolated; }
+};
+} // namespace mouthbreather
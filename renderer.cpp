@@ -0,0 +1,119 @@
+#include "renderer.hpp"
+#include "metrics.hpp"
+#include <charconv>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+// move the terminal cursor, rows and columns count from 1
+void move_cursor(std::string& frame, std::int64_t row, std::int64_t column)
+{
+    char number[24];
+    frame += "\x1b[";
+    frame.append(number, std::to_chars(number, number + sizeof(number), row).ptr);
+    frame += ';';
+    frame.append(number, std::to_chars(number, number + sizeof(number), column).ptr);
+    frame += 'H';
+}
+} // namespace
+
+// bring the screen up to date, with just the changes if possible
+std::int64_t mouthbreather::Renderer::draw()
+{
+    if(_delta && _position >= 0 && _grid.changes_kept_since(_position) && _corner == _shown_corner)
+        return draw_changes();
+    return draw_full();
+}
+
+// the whole viewport
+std::int64_t mouthbreather::Renderer::draw_full()
+{
+    _frame.clear();
+    _frame.reserve(_grid.frame_size(_view) + 8);
+    if(_delta)
+        _frame += "\x1b[H\x1b[2J"; // top left of a blank screen, so cell positions are known
+    _grid.render(_frame, _corner, _view);
+    _position = _grid.change_position();
+    _shown_corner = _corner;
+    write();
+    return std::int64_t(_frame.size());
+}
+
+// only the cells changed since the last frame
+std::int64_t mouthbreather::Renderer::draw_changes()
+{
+    _frame.clear();
+    int width = _grid.cell_size() + 1; // every cell is followed by a |
+    for(std::int64_t index : _grid.changes_since(_position)) {
+        Coordinates cell = _grid.coordinates_of(index);
+        if(cell.x < _corner.x || cell.x >= _corner.x + _view.x || cell.y < _corner.y || cell.y >= _corner.y + _view.y)
+            continue; // off screen
+        // the top row is drawn first and the index column is the first thing on every line
+        move_cursor(_frame, _corner.y + _view.y - cell.y, std::int64_t(cell.x - _corner.x + 1) * width + 1);
+        _frame += _grid.cell_text(index);
+    }
+    // park the cursor under the grid and wipe out the prompts printed there since the last frame
+    move_cursor(_frame, _view.y + 2, 1);
+    _frame += "\x1b[J";
+    _position = _grid.change_position();
+    write();
+    return std::int64_t(_frame.size());
+}
+
+// the whole frame in one write
+void mouthbreather::Renderer::write()
+{
+    Game_Metrics* metrics = _grid.metrics();
+    Scoped_Timer timer(metrics ? &metrics->display : nullptr);
+    std::cout.flush(); // anything already printed has to come out first
+    std::fwrite(_frame.data(), 1, _frame.size(), stdout);
+    std::fflush(stdout);
+    _bytes_written += std::int64_t(_frame.size());
+    if(metrics)
+        metrics->bytes_displayed += std::int64_t(_frame.size());
+}
+
+// shrink the viewport to what fits on a terminal that size
+void mouthbreather::Renderer::fit(Coordinates terminal)
+{
+    Coordinates size = _grid.room_size();
+    if(terminal.x <= 0 || terminal.y <= 0) {
+        _view = size;
+    } else {
+        // one column and one row go to the index labels, and a few rows at the bottom are left for the prompts
+        _view.x = std::clamp(terminal.x / (_grid.cell_size() + 1) - 1, 1, size.x);
+        _view.y = std::clamp(terminal.y - 4, 1, size.y);
+    }
+    _corner.x = std::clamp(_corner.x, 1, size.x - _view.x + 1);
+    _corner.y = std::clamp(_corner.y, 1, size.y - _view.y + 1);
+}
+
+// move the viewport so location is in the middle of it, unless it's already on screen
+void mouthbreather::Renderer::focus(Coordinates location)
+{
+    Coordinates size = _grid.room_size();
+    if(location.x < _corner.x || location.x >= _corner.x + _view.x)
+        _corner.x = std::clamp(location.x - _view.x / 2, 1, size.x - _view.x + 1);
+    if(location.y < _corner.y || location.y >= _corner.y + _view.y)
+        _corner.y = std::clamp(location.y - _view.y / 2, 1, size.y - _view.y + 1);
+}
+
+// move the viewport by half its size
+void mouthbreather::Renderer::scroll(int columns, int rows)
+{
+    Coordinates size = _grid.room_size();
+    _corner.x = std::clamp(_corner.x + columns * std::max(_view.x / 2, 1), 1, size.x - _view.x + 1);
+    _corner.y = std::clamp(_corner.y + rows * std::max(_view.y / 2, 1), 1, size.y - _view.y + 1);
+}
+
+// how many columns and rows the terminal on stdout has
+Coordinates mouthbreather::terminal_size()
+{
+    winsize window;
+    if(ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) != 0)
+        return Coordinates(0, 0);
+    return Coordinates(window.ws_col, window.ws_row);
+}
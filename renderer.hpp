@@ -0,0 +1,51 @@
+#pragma once
+#include "mouthbreather.hpp"
+
+namespace mouthbreather
+{
+// draws a Grid into one reusable buffer and writes it out with a single call
+// in delta mode only the cells that changed since the last frame get drawn, each one reached with an ANSI cursor
+// escape, so a move costs about as much as the cells it changed instead of the whole room
+// rooms bigger than the screen are shown through a viewport, only the cells inside it (and their index labels) are
+// ever drawn, so the cost depends on the size of the screen and not the room
+class Renderer
+{
+    Grid& _grid;
+    bool _delta;
+    std::string _frame;
+    std::int64_t _position = -1; // the grid's change_position() as of the last frame, -1 before the first one
+    std::int64_t _bytes_written = 0;
+    Coordinates _corner;       // bottom left cell of the viewport
+    Coordinates _view;         // how many columns and rows of cells the viewport holds
+    Coordinates _shown_corner; // where the viewport was when the last frame was drawn
+
+    void write();
+
+public:
+    Renderer(Grid& grid, bool delta)
+        : _grid(grid)
+        , _delta(delta)
+        , _corner(1, 1)
+        , _view(grid.room_size())
+        , _shown_corner(1, 1){};
+    // bring the screen up to date, with just the changes if possible, returns how many bytes that took
+    std::int64_t draw();
+    // the whole viewport, in delta mode the screen is cleared first so later changes land in the right place
+    std::int64_t draw_full();
+    // only the cells changed since the last frame, needs delta mode and a full frame before it
+    std::int64_t draw_changes();
+    std::int64_t bytes_written() { return _bytes_written; }
+
+    // shrink the viewport to what fits on a terminal that many columns and rows big, leaving room for prompts
+    void fit(Coordinates terminal);
+    // if the whole room doesn't fit, so there's something to scroll to
+    bool scrolls() { return !(_view == _grid.room_size()); }
+    // move the viewport so location is in the middle of it, unless it's already on screen
+    void focus(Coordinates location);
+    // move the viewport by half its size, columns is + for right, rows is + for up
+    void scroll(int columns, int rows);
+};
+
+// how many columns and rows the terminal on stdout has, 0 by 0 if it isn't one
+Coordinates terminal_size();
+} // namespace mouthbreather
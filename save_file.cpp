@@ -0,0 +1,177 @@
+/* save files
+ * a fixed size header, then the mouthbreather, revealed and flagged planes exactly as they sit in memory, 64 cells
+ * to a word, so loading is copying three blocks out of a mapped file instead of parsing anything per cell
+ * neighbor counts and the rest of the Cell contents aren't stored, they're worked out again from the planes
+ */
+
+#include "mouthbreather.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+constexpr char SAVE_MAGIC_[8] = { 'M', 'B', 'R', 'E', 'A', 'T', 'H', 'E' };
+constexpr std::uint32_t SAVE_VERSION_ = 1;
+constexpr std::uint32_t BYTE_ORDER_MARK_ = 0x01020304; // reads back differently on a machine with the other byte order
+
+struct Save_Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::int32_t width; // the room, not counting the index row/column
+    std::int32_t height;
+    std::uint64_t random_seed;
+    std::uint64_t words; // per plane
+    float frequency;     // 0 in files from before it was kept, those get it back from the mouthbreather count
+    std::uint32_t unused;
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(Save_Header) == 64);
+
+// write all of it, or fail
+bool write_all(int file, const void* data, std::size_t size)
+{
+    const char* at = static_cast<const char*>(data);
+    while(size > 0) {
+        ssize_t written = ::write(file, at, size);
+        if(written <= 0)
+            return false;
+        at += written;
+        size -= std::size_t(written);
+    }
+    return true;
+}
+} // namespace
+
+// write the room to path as a save file
+// it goes to a temporary file first and is renamed over path at the end, so a failed save never leaves half a file
+bool mouthbreather::Grid::save(const std::string& path)
+{
+    Save_Header header = {};
+    std::memcpy(header.magic, SAVE_MAGIC_, sizeof(header.magic));
+    header.version = SAVE_VERSION_;
+    header.byte_order = BYTE_ORDER_MARK_;
+    header.width = _size.x - 1;
+    header.height = _size.y - 1;
+    header.random_seed = _random_seed;
+    header.frequency = _frequency;
+    header.words = _planes.revealed.words().size();
+
+    std::string partial = path;
+    partial += ".partial";
+    int file = ::open(partial.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file < 0) {
+        std::cerr << partial << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::size_t plane_bytes = header.words * sizeof(std::uint64_t);
+    bool written = write_all(file, &header, sizeof(header)) &&
+                   write_all(file, _planes.mouthbreathers.words().data(), plane_bytes) &&
+                   write_all(file, _planes.revealed.words().data(), plane_bytes) &&
+                   write_all(file, _planes.flagged.words().data(), plane_bytes);
+    written = ::close(file) == 0 && written;
+    if(!written || std::rename(partial.c_str(), path.c_str()) != 0) {
+        std::cerr << path << ": couldn't save the room, " << std::strerror(errno) << std::endl;
+        std::remove(partial.c_str());
+        return false;
+    }
+    return true;
+}
+
+// a room read back from a save file
+std::unique_ptr<Grid> mouthbreather::Grid::load(const std::string& path)
+{
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) {
+        std::cerr << path << ": " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    struct stat status;
+    void* mapping = MAP_FAILED;
+    std::size_t size = 0;
+    if(fstat(file, &status) == 0 && std::size_t(status.st_size) >= sizeof(Save_Header)) {
+        size = std::size_t(status.st_size);
+        mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    ::close(file);
+    if(mapping == MAP_FAILED) {
+        std::cerr << path << ": not a save file" << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<Grid> room;
+    Save_Header header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if(std::memcmp(header.magic, SAVE_MAGIC_, sizeof(header.magic)) != 0)
+        std::cerr << path << ": not a save file" << std::endl;
+    else if(header.version != SAVE_VERSION_ || header.byte_order != BYTE_ORDER_MARK_)
+        std::cerr << path << ": saved by a different version, or on a different kind of machine" << std::endl;
+    else if(header.width < SIZE_MININUM_ || header.height < SIZE_MININUM_ || header.width > SIZE_LIMIT_ ||
+            header.height > SIZE_LIMIT_)
+        std::cerr << path << ": the room in it is the wrong size" << std::endl;
+    else {
+        room = std::make_unique<Grid>(Coordinates(header.width, header.height));
+        std::size_t plane_bytes = room->_planes.revealed.words().size() * sizeof(std::uint64_t);
+        if(header.words != room->_planes.revealed.words().size() || size != sizeof(header) + 3 * plane_bytes) {
+            std::cerr << path << ": cut short or damaged" << std::endl;
+            room.reset();
+        } else {
+            madvise(mapping, size, MADV_SEQUENTIAL);
+            const std::uint64_t* planes =
+                reinterpret_cast<const std::uint64_t*>(static_cast<const char*>(mapping) + sizeof(header));
+            room->restore(planes, planes + header.words, planes + 2 * header.words, header.random_seed,
+                          header.frequency);
+        }
+    }
+    munmap(mapping, size);
+    return room;
+}
+
+// rebuild the cells from saved planes
+// the border bits come from the constructor, never the file, so a damaged file can't open up the border
+void mouthbreather::Grid::restore(const std::uint64_t* mouthbreathers, const std::uint64_t* revealed,
+                                  const std::uint64_t* flagged, std::uint64_t random_seed, float frequency)
+{
+    std::vector<std::uint64_t>& playable = _planes.playable.words();
+    std::vector<std::uint64_t>& mine_words = _planes.mouthbreathers.words();
+    std::vector<std::uint64_t>& open_words = _planes.revealed.words();
+    std::vector<std::uint64_t>& flag_words = _planes.flagged.words();
+    for(std::size_t word = 0; word < playable.size(); ++word) {
+        mine_words[word] = mouthbreathers[word] & playable[word];
+        open_words[word] |= revealed[word] & playable[word];
+        flag_words[word] = flagged[word] & playable[word];
+    }
+
+    total_cells_selected = 0;
+    for(std::size_t word = 0; word < playable.size(); ++word) {
+        for(std::uint64_t bits = playable[word]; bits; bits &= bits - 1) {
+            std::int64_t index = std::int64_t(word) * 64 + std::countr_zero(bits);
+            Cell& cell = _contents[index];
+            cell.bits = _planes.mouthbreathers.test(index)
+                            ? Cell::MOUTHBREATHER
+                            : std::uint8_t(_planes.around(_planes.mouthbreathers, index));
+            bool flag = _planes.flagged.test(index);
+            if(_planes.revealed.test(index)) {
+                reveal(index);
+                ++total_cells_selected;
+            }
+            if(flag) {
+                _planes.flagged.set(index); // reveal() clears it
+                cell.bits |= Cell::FLAGGED;
+            }
+        }
+    }
+    _mouthbreather_count = _planes.mouthbreathers.count();
+    _random_seed = random_seed;
+    _frequency = frequency > 0 && frequency <= 1 ? frequency : float(double(_mouthbreather_count) / double(size()));
+    _openings.build(_planes);
+    _changes.clear();
+    _changes_forgotten = 0;
+}
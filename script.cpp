@@ -0,0 +1,140 @@
+#include "script.hpp"
+#include "metrics.hpp"
+#include "no_guess.hpp"
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+mouthbreather::Move_Script::~Move_Script()
+{
+    if(_mapping)
+        munmap(_mapping, _mapped);
+}
+
+// map a regular file straight in, read anything else into _buffer
+bool mouthbreather::Move_Script::open(const char* path)
+{
+    bool from_stdin = std::string_view(path) == "-";
+    int file = from_stdin ? STDIN_FILENO : ::open(path, O_RDONLY);
+    if(file < 0)
+        return false;
+    struct stat status;
+    if(fstat(file, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        _mapped = std::size_t(status.st_size);
+        _mapping = mmap(nullptr, _mapped, PROT_READ, MAP_PRIVATE, file, 0);
+        if(_mapping == MAP_FAILED)
+            _mapping = nullptr;
+        else {
+            madvise(_mapping, _mapped, MADV_SEQUENTIAL);
+            _next = static_cast<const char*>(_mapping);
+            _end = _next + _mapped;
+        }
+    }
+    if(!_mapping) {
+        char chunk[1 << 16];
+        ssize_t count;
+        while((count = read(file, chunk, sizeof(chunk))) > 0)
+            _buffer.append(chunk, std::size_t(count));
+        _next = _buffer.data();
+        _end = _next + _buffer.size();
+    }
+    if(!from_stdin)
+        close(file);
+    return true;
+}
+
+// one line, without its newline
+Parse_Result mouthbreather::parse_move(std::string_view line, Coordinates size, Move& move)
+{
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    const char* at = line.data();
+    const char* line_end = at + line.size();
+    while(at < line_end && is_space(*at))
+        ++at;
+    if(at == line_end || *at == '#')
+        return Parse_Result::blank;
+    move.action = *at++;
+    while(at < line_end && is_space(*at))
+        ++at;
+    int x = 0;
+    std::from_chars_result parsed = std::from_chars(at, line_end, x);
+    at = parsed.ptr;
+    while(at < line_end && is_space(*at))
+        ++at;
+    const char* letters = at;
+    while(at < line_end && *at >= 'A' && *at <= 'Z')
+        ++at;
+    int row = letter_to_number(std::string_view(letters, std::size_t(at - letters)));
+    while(at < line_end && is_space(*at))
+        ++at;
+
+    if((move.action != 's' && move.action != 'f') || parsed.ec != std::errc() || row < 0 || at != line_end)
+        return Parse_Result::malformed;
+    if(x < 1 || x > size.x || row >= size.y)
+        return Parse_Result::outside;
+    move.location = Coordinates(x, size.y - row); // same flip as user_choice, A is the top row
+    return Parse_Result::move;
+}
+
+// the next move that fits in a room that size
+bool mouthbreather::Move_Script::next(Move& move, Coordinates size)
+{
+    while(_next < _end) {
+        const char* line_end = static_cast<const char*>(std::memchr(_next, '\n', std::size_t(_end - _next)));
+        if(!line_end)
+            line_end = _end;
+        std::string_view line(_next, std::size_t(line_end - _next));
+        _next = line_end + 1;
+        ++_line;
+
+        Parse_Result result = parse_move(line, size, move);
+        if(result == Parse_Result::move)
+            return true;
+        if(result == Parse_Result::malformed)
+            std::cerr << "line " << _line << ": expected s x Y or f x Y" << std::endl;
+        else if(result == Parse_Result::outside)
+            std::cerr << "line " << _line << ": outside the room" << std::endl;
+    }
+    return false;
+}
+
+// play a whole script without prompting
+bool mouthbreather::play_script(Grid& room, Renderer& renderer, Move_Script& script, Game_Parameters& parameters,
+                                bool seeded)
+{
+    Move move;
+    std::int64_t moves = 0;
+    bool alive = true;
+    while(alive && !room.won() && script.next(move, parameters.size)) {
+        if(!seeded && move.action == 'f') { // there's no room to flag in until the first select seeds it
+            std::cerr << "line " << script.line() << ": flag before the first select, skipping it" << std::endl;
+            continue;
+        }
+        if(!seeded) { // seed clears the area around the first select itself, so selecting it again does nothing
+            if(parameters.no_guess)
+                seed_without_guessing(room, move.location, parameters.frequency, parameters.seed,
+                                      std::thread::hardware_concurrency());
+            else
+                room.seed(move.location, parameters.frequency, parameters.seed);
+            seeded = true;
+        }
+        if(move.action == 'f')
+            room.flag(move.location);
+        else
+            alive = room.select(move.location);
+        ++moves;
+    }
+    if(moves > 0)
+        renderer.focus(move.location);
+    renderer.draw();
+    room.forget_changes();
+    if(room.metrics())
+        publish_metrics(*room.metrics());
+    std::cout << moves << " moves played, up to line " << script.line() << std::endl;
+    return room.won();
+}
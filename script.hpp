@@ -0,0 +1,49 @@
+#pragma once
+#include "mouthbreather.hpp"
+#include "renderer.hpp"
+
+namespace mouthbreather
+{
+// one line of a move script
+struct Move {
+    char action = 's'; // s (select) or f (flag)
+    Coordinates location; // grid coordinates, the same thing user_choice returns
+};
+
+// what parse_move made of a line
+enum class Parse_Result { move, blank, malformed, outside };
+
+// one "s x Y" or "f x Y" line without its newline, blank covers comments too and outside is a move that doesn't fit
+// in a room that size, doesn't allocate or throw
+Parse_Result parse_move(std::string_view line, Coordinates size, Move& move);
+
+// a file of moves, one per line as "s x Y" or "f x Y" with the same x and Y as the prompts take, # starts a comment
+// a regular file is memory mapped, anything else (a pipe, - for stdin) is read in once, and lines are parsed in
+// place without allocating or throwing
+class Move_Script
+{
+    const char* _next = nullptr;
+    const char* _end = nullptr;
+    void* _mapping = nullptr;
+    std::size_t _mapped = 0;
+    std::string _buffer;
+    std::int64_t _line = 0;
+
+public:
+    Move_Script(){};
+    Move_Script(const Move_Script&) = delete;
+    Move_Script& operator=(const Move_Script&) = delete;
+    ~Move_Script();
+
+    // false if path can't be read
+    bool open(const char* path);
+    // the next move that fits in a room that size, false once there aren't any left
+    // lines that don't make sense are reported on std::cerr with their line number and skipped
+    bool next(Move& move, Coordinates size);
+    std::int64_t line() { return _line; }
+};
+
+// play a whole script without prompting, the first move's location is where the room gets seeded around unless it
+// already has been, only the final frame is drawn, true if the room was cleared
+bool play_script(Grid& room, Renderer& renderer, Move_Script& script, Game_Parameters& parameters, bool seeded);
+} // namespace mouthbreather
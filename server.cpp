@@ -0,0 +1,620 @@
+#include "server.hpp"
+#include "no_guess.hpp"
+#include "script.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace mouthbreather;
+
+namespace
+{
+// one connection and the game being played on it
+// the fields at the top belong to the event loop, the ones under lock are how it and the workers hand things over,
+// and the room is only touched by whichever worker has the session scheduled
+struct Session {
+    int socket = -1;
+    std::string in;  // read but not a whole line yet
+    std::string out; // waiting for the socket to take it
+    bool writing = false; // waiting for EPOLLOUT
+    bool hang_up = false; // close once out is written
+    bool finished = false; // the client has stopped sending, answer what it sent and hang up
+    bool closed = false;
+    bool watched = true; // in the epoll set, it comes out once the client's finished and there's nothing to send
+
+    std::mutex lock;
+    std::vector<std::string> commands; // whole lines waiting for a worker
+    std::string replies;               // answers waiting for the event loop
+    bool scheduled = false;            // queued for or being run by a worker
+    bool quit = false;
+
+    std::unique_ptr<Grid> room;
+    Move_Results results; // what the last move changed, kept so its buffer doesn't get reallocated every move
+    Coordinates size;
+    float frequency = DEFAULT_FREQUENCY_;
+    std::uint64_t random_seed = 0;
+    bool seeded = false;         // the room is seeded around the first select
+    std::uint64_t next_seed = 0; // each new room without a seed given takes the next one
+};
+
+void append_number(std::string& out, std::uint64_t number)
+{
+    char digits[24];
+    out.append(digits, std::to_chars(digits, digits + sizeof(digits), number).ptr);
+}
+
+class Server
+{
+    Game_Parameters& _parameters;
+    int _listener = -1;
+    int _epoll = -1;
+    int _wake = -1;    // eventfd the workers poke when they've left replies
+    int _signals = -1; // signalfd for SIGINT and SIGTERM, so stopping goes through the loop like everything else
+    std::unordered_map<int, std::shared_ptr<Session>> _sessions;
+    std::int64_t _connections = 0;
+    std::atomic<std::int64_t> _moves = 0;
+
+    std::mutex _queue_lock;
+    std::condition_variable _queue_ready;
+    std::deque<std::shared_ptr<Session>> _queue; // sessions with commands and no worker
+    bool _stopping = false;
+
+    std::mutex _ready_lock;
+    std::vector<std::shared_ptr<Session>> _ready; // sessions with replies for the loop to send
+
+    std::unique_ptr<No_Guess_Pool> _pool; // rooms that don't need a guess for the size it was started with, --no-guess
+
+    void accept_all();
+    void read(const std::shared_ptr<Session>& session);
+    void flush(const std::shared_ptr<Session>& session);
+    void watch(const std::shared_ptr<Session>& session);
+    void close(const std::shared_ptr<Session>& session);
+    void send_replies();
+    void schedule(const std::shared_ptr<Session>& session, std::vector<std::string>& lines);
+    void work();
+    void run(Session& session, std::string_view command, std::string& reply);
+    void new_room(Session& session, std::string_view arguments, std::string& reply);
+
+public:
+    Server(Game_Parameters& parameters)
+        : _parameters(parameters){};
+    ~Server();
+    bool start();
+    void loop();
+};
+
+Server::~Server()
+{
+    for(auto& [socket, session] : _sessions)
+        ::close(socket);
+    for(int file : { _listener, _epoll, _wake, _signals }) {
+        if(file >= 0)
+            ::close(file);
+    }
+    if(_listener >= 0 && _parameters.serve.find(':') == std::string::npos)
+        unlink(_parameters.serve.c_str()); // the socket file is ours as long as we were listening on it
+}
+
+bool Server::start()
+{
+    // every client starts out with this room, so one no client could ask for isn't one to start with either
+    Coordinates size = _parameters.size;
+    if(size.x < SIZE_MININUM_ || size.y < SIZE_MININUM_ || size.x > SERVER_ROOM_LIMIT_ ||
+       size.y > SERVER_ROOM_LIMIT_ || _parameters.frequency <= 0 || _parameters.frequency > 1) {
+        std::cerr << "a server's rooms have to be " << SIZE_MININUM_ << " to " << SERVER_ROOM_LIMIT_
+                  << " cells on a side with a frequency above 0 and at most 1" << std::endl;
+        return false;
+    }
+    _listener = listen_on(_parameters.serve);
+    if(_listener < 0)
+        return false;
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr); // before the workers start, so they inherit it
+    if(_parameters.no_guess) { // other sizes still get them, just looked for on the spot
+        _pool = std::make_unique<No_Guess_Pool>(std::max(_parameters.threads, 1u));
+        _pool->stock(_parameters.size, _parameters.frequency, _parameters.seed);
+    }
+    _signals = signalfd(-1, &stop_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    _wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if(_signals < 0 || _wake < 0 || _epoll < 0) {
+        std::cerr << "can't set up the event loop: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    for(int file : { _listener, _wake, _signals }) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = file;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, file, &event);
+    }
+    return true;
+}
+
+// everything that's waiting to connect
+void Server::accept_all()
+{
+    for(;;) {
+        int socket = accept4(_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(socket < 0)
+            return; // EAGAIN, or the client gave up before we got to it
+        int on = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)); // fails harmlessly on a Unix socket
+        auto session = std::make_shared<Session>();
+        session->socket = socket;
+        session->size = _parameters.size;
+        session->frequency = _parameters.frequency;
+        session->next_seed = _parameters.seed + std::uint64_t(_connections++) * 0x9e3779b97f4a7c15;
+        _sessions[socket] = session;
+        epoll_event event{};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = socket;
+        epoll_ctl(_epoll, EPOLL_CTL_ADD, socket, &event);
+        std::vector<std::string> greeting{ "n" }; // the worker makes the first room and says so
+        schedule(session, greeting);
+    }
+}
+
+// everything the socket has, split into lines for a worker
+void Server::read(const std::shared_ptr<Session>& session)
+{
+    if(session->finished) // a hang up still being reported while the last replies go out
+        return;
+    char buffer[1 << 14];
+    for(;;) {
+        ssize_t count = recv(session->socket, buffer, sizeof(buffer), 0);
+        if(count > 0) {
+            session->in.append(buffer, std::size_t(count));
+            continue;
+        }
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if(count < 0) {
+            close(session); // broken
+            return;
+        }
+        // the client is done sending, stop listening for it but still answer whatever it sent
+        session->finished = true;
+        watch(session);
+        break;
+    }
+    std::vector<std::string> lines;
+    std::size_t begin = 0;
+    for(std::size_t end; (end = session->in.find('\n', begin)) != std::string::npos; begin = end + 1) {
+        std::size_t length = end - begin;
+        if(length > 0 && session->in[end - 1] == '\r')
+            --length;
+        if(length > 0)
+            lines.emplace_back(session->in, begin, length);
+    }
+    session->in.erase(0, begin);
+    if(session->in.size() > SERVER_LINE_LIMIT_) {
+        session->out += "error line too long\n";
+        session->hang_up = true;
+        flush(session);
+        return;
+    }
+    if(session->finished)
+        lines.emplace_back("q");
+    if(!lines.empty())
+        schedule(session, lines);
+}
+
+// send as much of out as the socket will take, and wait for EPOLLOUT if that isn't all of it
+void Server::flush(const std::shared_ptr<Session>& session)
+{
+    std::size_t sent = 0;
+    while(sent < session->out.size()) {
+        ssize_t count = send(session->socket, session->out.data() + sent, session->out.size() - sent,
+                             MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(count < 0 && errno == EINTR)
+            continue;
+        if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if(count <= 0) {
+            close(session);
+            return;
+        }
+        sent += std::size_t(count);
+    }
+    session->out.erase(0, sent);
+    bool waiting = !session->out.empty();
+    if(waiting != session->writing) {
+        session->writing = waiting;
+        watch(session);
+    }
+    if(!waiting && session->hang_up)
+        close(session);
+}
+
+// wait for lines until the client stops sending and for room to write while replies are backed up
+// with neither the socket comes out of the epoll set altogether, a hang up is reported whether it's asked for or not
+// and would wake the loop over and over until the workers' last replies have gone out
+void Server::watch(const std::shared_ptr<Session>& session)
+{
+    epoll_event event{};
+    event.events = (session->finished ? 0u : EPOLLIN | EPOLLRDHUP) | (session->writing ? EPOLLOUT : 0u);
+    event.data.fd = session->socket;
+    if(event.events == 0) {
+        if(session->watched)
+            epoll_ctl(_epoll, EPOLL_CTL_DEL, session->socket, nullptr);
+        session->watched = false;
+        return;
+    }
+    epoll_ctl(_epoll, session->watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, session->socket, &event);
+    session->watched = true;
+}
+
+// a worker might still have it, closed keeps the loop from writing to a socket number that's been handed out again
+void Server::close(const std::shared_ptr<Session>& session)
+{
+    if(session->closed)
+        return;
+    session->closed = true;
+    if(session->watched)
+        epoll_ctl(_epoll, EPOLL_CTL_DEL, session->socket, nullptr);
+    ::close(session->socket);
+    _sessions.erase(session->socket);
+}
+
+// pick up whatever the workers have answered
+void Server::send_replies()
+{
+    std::uint64_t pokes;
+    while(::read(_wake, &pokes, sizeof(pokes)) > 0) {
+    }
+    std::vector<std::shared_ptr<Session>> ready;
+    {
+        std::lock_guard<std::mutex> guard(_ready_lock);
+        ready.swap(_ready);
+    }
+    for(std::shared_ptr<Session>& session : ready) {
+        if(session->closed)
+            continue;
+        {
+            std::lock_guard<std::mutex> guard(session->lock);
+            session->out += session->replies;
+            session->replies.clear();
+            session->hang_up = session->hang_up || session->quit;
+        }
+        flush(session);
+    }
+}
+
+// hand lines to a worker, unless one is already running this session, then it'll pick them up itself
+void Server::schedule(const std::shared_ptr<Session>& session, std::vector<std::string>& lines)
+{
+    {
+        std::lock_guard<std::mutex> guard(session->lock);
+        for(std::string& line : lines)
+            session->commands.push_back(std::move(line));
+        if(session->scheduled)
+            return;
+        session->scheduled = true;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_queue_lock);
+        _queue.push_back(session);
+    }
+    _queue_ready.notify_one();
+}
+
+// take a session, run its commands until there aren't any left, repeat
+void Server::work()
+{
+    std::vector<std::string> commands;
+    std::string replies;
+    for(;;) {
+        std::shared_ptr<Session> session;
+        {
+            std::unique_lock<std::mutex> guard(_queue_lock);
+            _queue_ready.wait(guard, [&] { return _stopping || !_queue.empty(); });
+            if(_stopping)
+                return;
+            session = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        for(;;) {
+            {
+                std::lock_guard<std::mutex> guard(session->lock);
+                if(session->commands.empty() || session->quit) {
+                    session->scheduled = false;
+                    break;
+                }
+                commands.swap(session->commands);
+            }
+            replies.clear();
+            bool quit = false;
+            for(std::string& command : commands) {
+                if(command == "q") {
+                    quit = true;
+                    break;
+                }
+                run(*session, command, replies);
+            }
+            commands.clear();
+            {
+                std::lock_guard<std::mutex> guard(session->lock);
+                session->replies += replies;
+                session->quit = quit;
+            }
+            {
+                std::lock_guard<std::mutex> guard(_ready_lock);
+                _ready.push_back(session);
+            }
+            std::uint64_t poke = 1;
+            if(::write(_wake, &poke, sizeof(poke)) < 0) {
+                // the counter is full, the loop has plenty of pokes already
+            }
+        }
+    }
+}
+
+// one command, one line of reply
+void Server::run(Session& session, std::string_view command, std::string& reply)
+{
+    if(command[0] == 'n') {
+        new_room(session, command.substr(1), reply);
+        return;
+    }
+    if(!session.room) { // the n it connected with couldn't make a room
+        reply += "error send n\n";
+        return;
+    }
+    Grid& room = *session.room;
+    if(room.won() || room.lost()) {
+        reply += "error game over, send n\n";
+        return;
+    }
+    Move move;
+    Parse_Result parsed = parse_move(command, session.size, move);
+    if(parsed != Parse_Result::move) {
+        reply += parsed == Parse_Result::outside ? "error outside the room\n" : "error expected s x Y, f x Y, n or q\n";
+        return;
+    }
+
+    if(move.action == 'f' && !session.seeded) { // the room isn't laid out yet, seeding would wipe the flag off
+        reply += "error select somewhere first\n";
+        return;
+    }
+
+    std::span<Coordinates> locations(&move.location, 1);
+    if(move.action == 'f')
+        room.flag_many(locations, session.results);
+    else if(!session.seeded) { // seed clears the area around the first select itself
+        std::int64_t position = room.change_position();
+        std::int64_t selected_before = room.number_selected();
+        if(_parameters.no_guess) // the worker's the only thread this session gets, so it looks on its own
+            seed_without_guessing(room, move.location, session.frequency, session.random_seed, 1, _pool.get());
+        else
+            room.seed(move.location, session.frequency, session.random_seed);
+        session.seeded = true;
+        room.describe_changes(position, selected_before, session.results);
+    } else
+        room.select_many(locations, session.results);
+    ++_moves;
+
+    reply += room.won() ? "won " : room.lost() ? "lost " : "play ";
+    append_number(reply, session.results.changes.size());
+    for(const Cell_Change& change : session.results.changes) {
+        Coordinates cell = room.coordinates_of(change.index);
+        reply += ' ';
+        append_number(reply, std::uint64_t(cell.x));
+        reply += ' ';
+        reply += number_to_letter(session.size.y - cell.y + 1);
+        reply += ' ';
+        reply += change.code;
+    }
+    reply += '\n';
+    room.forget_changes();
+}
+
+// n [X Y [F [SEED]]]
+void Server::new_room(Session& session, std::string_view arguments, std::string& reply)
+{
+    std::uint64_t values[4] = { std::uint64_t(_parameters.size.x), std::uint64_t(_parameters.size.y), 0,
+                                session.next_seed };
+    float frequency = _parameters.frequency;
+    const char* at = arguments.data();
+    const char* end = at + arguments.size();
+    int given = 0;
+    bool bad = false;
+    for(; given < 4; ++given) {
+        while(at < end && *at == ' ')
+            ++at;
+        if(at == end)
+            break;
+        std::from_chars_result parsed =
+            given == 2 ? std::from_chars(at, end, frequency) : std::from_chars(at, end, values[given]);
+        bad = bad || parsed.ec != std::errc();
+        at = parsed.ptr;
+    }
+    while(at < end && *at == ' ')
+        ++at;
+    Coordinates size(int(std::min<std::uint64_t>(values[0], SERVER_ROOM_LIMIT_ + 1)),
+                     int(std::min<std::uint64_t>(values[1], SERVER_ROOM_LIMIT_ + 1)));
+    if(bad || at != end || given == 1) {
+        reply += "error expected n [X Y [F [SEED]]]\n";
+        return;
+    }
+    if(size.x < SIZE_MININUM_ || size.y < SIZE_MININUM_ || size.x > SERVER_ROOM_LIMIT_ ||
+       size.y > SERVER_ROOM_LIMIT_ || frequency <= 0 || frequency > 1) {
+        reply += "error that room can't be made\n";
+        return;
+    }
+    try {
+        session.room = std::make_unique<Grid>(size);
+    } catch(const std::bad_alloc& ba) {
+        reply += "error not enough memory\n";
+        return;
+    }
+    if(given < 4)
+        ++session.next_seed;
+    session.size = size;
+    session.frequency = frequency;
+    session.random_seed = values[3];
+    session.seeded = false;
+    reply += "game ";
+    append_number(reply, std::uint64_t(size.x));
+    reply += ' ';
+    append_number(reply, std::uint64_t(size.y));
+    reply += ' ';
+    append_number(reply, values[3]);
+    reply += '\n';
+}
+
+void Server::loop()
+{
+    std::vector<std::thread> workers;
+    for(unsigned id = 0; id < std::max(_parameters.threads, 1u); ++id)
+        workers.emplace_back([this] { work(); });
+    std::cout << "serving on " << _parameters.serve << " with " << workers.size() << " worker(s)" << std::endl;
+
+    epoll_event events[SERVER_EVENTS_];
+    bool running = true;
+    while(running) {
+        int count = epoll_wait(_epoll, events, SERVER_EVENTS_, -1);
+        if(count < 0 && errno != EINTR) {
+            std::cerr << "epoll_wait: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        for(int i = 0; i < count; ++i) {
+            int file = events[i].data.fd;
+            if(file == _listener) {
+                accept_all();
+            } else if(file == _wake) {
+                send_replies();
+            } else if(file == _signals) {
+                running = false;
+            } else {
+                auto found = _sessions.find(file);
+                if(found == _sessions.end())
+                    continue; // closed earlier in this batch
+                std::shared_ptr<Session> session = found->second;
+                if(events[i].events & EPOLLOUT)
+                    flush(session);
+                if(!session->closed && events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                    read(session);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(_queue_lock);
+        _stopping = true;
+    }
+    _queue_ready.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+    std::cout << "served " << _connections << " connection(s), " << _moves << " move(s)" << std::endl;
+}
+
+// split host:port, false if it isn't one
+bool tcp_address(const std::string& address, sockaddr_in& out)
+{
+    std::size_t colon = address.rfind(':');
+    if(colon == std::string::npos)
+        return false;
+    unsigned port = 0;
+    const char* begin = address.data() + colon + 1;
+    const char* end = address.data() + address.size();
+    std::from_chars_result parsed = std::from_chars(begin, end, port);
+    std::string host = address.substr(0, colon);
+    out = sockaddr_in{};
+    out.sin_family = AF_INET;
+    out.sin_port = htons(std::uint16_t(port));
+    return parsed.ec == std::errc() && parsed.ptr == end && port <= 0xffff &&
+           inet_pton(AF_INET, host.empty() ? "127.0.0.1" : host.c_str(), &out.sin_addr) == 1;
+}
+
+bool unix_address(const std::string& path, sockaddr_un& out)
+{
+    out = sockaddr_un{};
+    out.sun_family = AF_UNIX;
+    if(path.empty() || path.size() >= sizeof(out.sun_path))
+        return false;
+    std::memcpy(out.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+} // namespace
+
+// a listening socket for a path or host:port
+int mouthbreather::listen_on(const std::string& address)
+{
+    sockaddr_in tcp;
+    sockaddr_un local;
+    bool is_tcp = address.find(':') != std::string::npos;
+    if(is_tcp ? !tcp_address(address, tcp) : !unix_address(address, local)) {
+        std::cerr << address << ": expected a socket path or host:port" << std::endl;
+        return -1;
+    }
+    int listener = socket(is_tcp ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int on = 1;
+    if(is_tcp)
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct stat status;
+    if(!is_tcp && stat(address.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        unlink(address.c_str()); // left behind by a server that's gone
+    bool bound = is_tcp ? bind(listener, reinterpret_cast<sockaddr*>(&tcp), sizeof(tcp)) == 0
+                        : bind(listener, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+    if(listener < 0 || !bound || listen(listener, SOMAXCONN) != 0) {
+        std::cerr << address << ": " << std::strerror(errno) << std::endl;
+        if(listener >= 0)
+            ::close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+// a blocking socket connected to a path or host:port
+int mouthbreather::connect_to(const std::string& address)
+{
+    sockaddr_in tcp;
+    sockaddr_un local;
+    bool is_tcp = address.find(':') != std::string::npos;
+    if(is_tcp ? !tcp_address(address, tcp) : !unix_address(address, local)) {
+        std::cerr << address << ": expected a socket path or host:port" << std::endl;
+        return -1;
+    }
+    int connection = socket(is_tcp ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool connected = is_tcp ? connect(connection, reinterpret_cast<sockaddr*>(&tcp), sizeof(tcp)) == 0
+                            : connect(connection, reinterpret_cast<sockaddr*>(&local), sizeof(local)) == 0;
+    if(connection < 0 || !connected) {
+        std::cerr << address << ": " << std::strerror(errno) << std::endl;
+        if(connection >= 0)
+            ::close(connection);
+        return -1;
+    }
+    int on = 1;
+    if(is_tcp)
+        setsockopt(connection, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    return connection;
+}
+
+// many games in one process
+bool mouthbreather::run_server(Game_Parameters& parameters)
+{
+    Server server(parameters);
+    if(!server.start())
+        return false;
+    server.loop();
+    return true;
+}
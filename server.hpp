@@ -0,0 +1,33 @@
+#pragma once
+#include "mouthbreather.hpp"
+
+namespace mouthbreather
+{
+constexpr std::size_t SERVER_LINE_LIMIT_ = 1 << 12; // a client sending a line longer than this gets cut off
+constexpr int SERVER_ROOM_LIMIT_ = 1 << 12;         // how big a room a client can ask for
+constexpr int SERVER_EVENTS_ = 256;                 // how many ready sockets one epoll_wait hands back
+
+/* many games in one process, one per connection
+ * a line protocol on a Unix domain socket (ADDRESS is a path) or loopback TCP (ADDRESS is host:port)
+ * client sends one command per line:
+ *   s x Y, f x Y       select or flag, the same x and Y the prompts take, the first select lays the room out so
+ *                      there's nothing to flag before it
+ *   n [X Y [F [SEED]]] start over with a new room, anything left out is what the server was started with
+ *   q                  hang up
+ * server answers every command with exactly one line:
+ *   game X Y SEED                      a new room is ready (also sent as soon as a client connects)
+ *   STATE COUNT x Y C x Y C...         after s or f, STATE is play, won or lost and then every cell that changed,
+ *                                      C is 0-8, * for a mouthbreather, + for a flag or . for hidden
+ *   error WHAT                         the command didn't do anything
+ * one thread runs an epoll loop that does all the reading and writing, parameters.threads workers run the moves,
+ * each session's commands are run in order by one worker at a time
+ * with parameters.no_guess every room can be cleared without guessing, ones the size the server was started with
+ * come out of a pool filled in the background
+ */
+// false if it couldn't start listening
+bool run_server(Game_Parameters& parameters);
+
+// a socket for address (a path or host:port), listening or connected, -1 with a message on std::cerr if it can't be
+int listen_on(const std::string& address);
+int connect_to(const std::string& address);
+} // namespace mouthbreather
@@ -0,0 +1,169 @@
+#include "simulation.hpp"
+#include "no_guess.hpp"
+#include <chrono>
+#include <iomanip>
+
+using namespace mouthbreather;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// a random hidden cell that isn't next to a number or proven either way, -1 if there aren't any
+// a few random guesses first, then a walk over the revealed plane from a random word once the room is mostly clear
+std::int64_t random_unconstrained_cell(Grid& room, Solver& solver, const Mine_Probabilities& probabilities,
+                                       Random_Generator& random)
+{
+    const Bit_Board& planes = room.planes();
+    auto unconstrained = [&](std::int64_t index) {
+        return !planes.revealed.test(index) && !solver.proven_mine(index) && !solver.proven_safe(index) &&
+               !probabilities.frontier.count(index);
+    };
+    Coordinates size = room.room_size();
+    for(int attempt = 0; attempt < 32; ++attempt) {
+        Coordinates pick(int(random.below(size.x)) + 1, int(random.below(size.y)) + 1);
+        std::int64_t index = room.index_of(pick);
+        if(unconstrained(index))
+            return index;
+    }
+    const std::vector<std::uint64_t>& playable = planes.playable.words();
+    const std::vector<std::uint64_t>& revealed = planes.revealed.words();
+    const std::vector<std::uint64_t>& mines = solver.mines().words();
+    std::size_t start = random.below(playable.size());
+    for(std::size_t step = 0; step < playable.size(); ++step) {
+        std::size_t word = (start + step) % playable.size();
+        for(std::uint64_t hidden = playable[word] & ~revealed[word] & ~mines[word]; hidden; hidden &= hidden - 1) {
+            std::int64_t index = std::int64_t(word) * 64 + std::countr_zero(hidden);
+            if(unconstrained(index))
+                return index;
+        }
+    }
+    return -1;
+}
+
+// the hidden cell least likely to be a mouthbreather, -1 if there aren't any
+// ties on the frontier go to the lowest index so the same game always guesses the same way
+std::int64_t safest_guess(Grid& room, Solver& solver, Random_Generator& random)
+{
+    const Mine_Probabilities& probabilities = solver.probabilities();
+    std::int64_t best = -1;
+    double lowest = 2;
+    for(const auto& [index, probability] : probabilities.frontier) {
+        if(probability < lowest || (probability == lowest && index < best)) {
+            best = index;
+            lowest = probability;
+        }
+    }
+    if(probabilities.unconstrained > 0 && (best < 0 || probabilities.elsewhere < lowest)) {
+        std::int64_t index = random_unconstrained_cell(room, solver, probabilities, random);
+        if(index >= 0)
+            return index;
+    }
+    return best;
+}
+} // namespace
+
+// play one game to the end without anyone watching
+// the player opens somewhere random, then plays whatever the solver proves safe, and when it can't, guesses the cell
+// least likely to be a mouthbreather
+bool mouthbreather::play_automatically(Grid& room, float frequency, Random_Generator& random,
+                                       Simulation_Results& results, bool no_guess)
+{
+    Coordinates size = room.room_size();
+    Coordinates start(int(random.below(size.x)) + 1, int(random.below(size.y)) + 1);
+    Clock::time_point seeding = Clock::now();
+    if(no_guess)
+        seed_without_guessing(room, start, frequency, random.next(), 1);
+    else
+        room.seed(start, frequency, random.next());
+    results.seed_seconds += seconds_since(seeding);
+    results.minimum_clicks += room.minimum_clicks();
+    Solver solver(room);
+    std::int64_t index = room.index_of(start);
+
+    while(!room.won()) {
+        if(index < 0) {
+            Clock::time_point solving = Clock::now();
+            solver.update();
+            index = solver.next_safe();
+            if(index < 0) {
+                index = safest_guess(room, solver, random);
+                ++results.guesses;
+            }
+            results.solve_seconds += seconds_since(solving);
+        }
+        if(index < 0)
+            break;
+        Coordinates choice = room.coordinates_of(index);
+        Clock::time_point selecting = Clock::now();
+        bool safe = room.select(choice);
+        results.select_seconds += seconds_since(selecting);
+        ++results.selects;
+        if(!safe)
+            return false;
+        index = -1;
+    }
+    return room.won();
+}
+
+// play a batch of games on a pool of threads that take the next game number until they run out
+Simulation_Results mouthbreather::simulate(Game_Parameters& parameters)
+{
+    unsigned threads = std::max(parameters.threads, 1u);
+    std::vector<Simulation_Results> per_thread(threads);
+    std::atomic<std::int64_t> next_game = 0;
+
+    auto work = [&](unsigned id) {
+        Simulation_Results& results = per_thread[id];
+        for(std::int64_t game = next_game++; game < parameters.simulate; game = next_game++) {
+            Random_Generator random(parameters.seed + std::uint64_t(game));
+            Grid room(parameters.size);
+            ++results.games;
+            if(play_automatically(room, parameters.frequency, random, results, parameters.no_guess))
+                ++results.wins;
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> workers;
+    for(unsigned id = 1; id < threads; ++id)
+        workers.emplace_back(work, id);
+    work(0);
+    for(std::thread& worker : workers)
+        worker.join();
+
+    Simulation_Results total;
+    total.seconds = seconds_since(start);
+    for(Simulation_Results& results : per_thread) {
+        total.games += results.games;
+        total.wins += results.wins;
+        total.selects += results.selects;
+        total.seed_seconds += results.seed_seconds;
+        total.select_seconds += results.select_seconds;
+        total.solve_seconds += results.solve_seconds;
+        total.guesses += results.guesses;
+        total.minimum_clicks += results.minimum_clicks;
+    }
+    return total;
+}
+
+// games/second, average seed and select time, and how many were won
+void mouthbreather::report(Simulation_Results& results, unsigned threads, std::ostream& out)
+{
+    auto average_microseconds = [](double seconds, std::int64_t count) { return count ? seconds * 1e6 / count : 0.0; };
+    out << std::fixed << std::setprecision(2);
+    out << "games: " << results.games << " on " << threads << " thread(s) in " << results.seconds << " s\n";
+    out << "games/second: " << (results.seconds > 0 ? results.games / results.seconds : 0.0) << "\n";
+    out << "average seed: " << average_microseconds(results.seed_seconds, results.games) << " us\n";
+    out << "average 3BV: " << (results.games ? double(results.minimum_clicks) / results.games : 0.0) << "\n";
+    out << "average select: " << average_microseconds(results.select_seconds, results.selects) << " us ("
+        << results.selects << " selects, " << results.guesses << " of them guesses)\n";
+    out << "average solve: " << average_microseconds(results.solve_seconds, results.selects) << " us\n";
+    out << "win rate: " << (results.games ? 100.0 * results.wins / results.games : 0.0) << "% (" << results.wins
+        << " won)" << std::endl;
+}
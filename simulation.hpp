@@ -0,0 +1,32 @@
+#pragma once
+#include "mouthbreather.hpp"
+#include "solver.hpp"
+
+namespace mouthbreather
+{
+// what came out of a batch of headless games
+struct Simulation_Results {
+    std::int64_t games = 0;
+    std::int64_t wins = 0;
+    std::int64_t selects = 0;
+    double seconds = 0;        // wall clock for the whole batch
+    double seed_seconds = 0;   // added up over every game
+    double select_seconds = 0; // added up over every select the player made
+    double solve_seconds = 0;  // added up over every time the solver was asked for a move
+    std::int64_t guesses = 0;  // selects the solver couldn't prove safe
+    std::int64_t minimum_clicks = 0; // every room's 3BV added up, how hard the rooms were
+};
+
+// play parameters.simulate games of parameters.size and parameters.frequency on parameters.threads threads
+// every game gets its own Grid and its own random stream (from parameters.seed and the game's number), so the same
+// parameters play the same games no matter how many threads there are
+Simulation_Results simulate(Game_Parameters& parameters);
+
+// play one game to the end without anyone watching, true if it was won
+// no_guess makes a room it can clear without guessing, looked for on one thread
+bool play_automatically(Grid& room, float frequency, Random_Generator& random, Simulation_Results& results,
+                        bool no_guess = false);
+
+// games/second, average seed and select time, and how many were won
+void report(Simulation_Results& results, unsigned threads, std::ostream& out);
+} // namespace mouthbreather
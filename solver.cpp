@@ -0,0 +1,655 @@
+#include "solver.hpp"
+
+using namespace mouthbreather;
+
+// try every layout of a component that agrees with all of its numbers
+// it's a depth first search over the cells in order, a number stops a branch as soon as it has too many mouthbreathers
+// or can't get enough from the cells it has left
+Component_Layouts mouthbreather::enumerate_layouts(const Frontier_Component& component)
+{
+    Component_Layouts result;
+    std::size_t cells = component.cells.size();
+    if(cells > COMPONENT_CELL_LIMIT_) {
+        result.complete = false;
+        return result;
+    }
+    std::vector<std::vector<int>> numbers_on(cells);
+    std::vector<int> placed(component.numbers.size(), 0);
+    std::vector<int> open(component.numbers.size(), 0);
+    for(std::size_t number = 0; number < component.numbers.size(); ++number) {
+        open[number] = int(component.touching[number].size());
+        for(int cell : component.touching[number])
+            numbers_on[cell].push_back(int(number));
+    }
+    std::vector<char> choice(cells, 0);
+    result.layouts.assign(cells + 1, 0);
+    result.cell_mines.assign(cells + 1, std::vector<double>(cells, 0));
+    std::int64_t steps = 0;
+
+    auto search = [&](auto& self, std::size_t cell, int mines) -> void {
+        if(!result.complete)
+            return;
+        if(++steps > ENUMERATION_STEP_LIMIT_) {
+            result.complete = false;
+            return;
+        }
+        if(cell == cells) {
+            result.layouts[mines] += 1;
+            for(std::size_t other = 0; other < cells; ++other) {
+                if(choice[other])
+                    result.cell_mines[mines][other] += 1;
+            }
+            return;
+        }
+        for(int value = 0; value <= 1; ++value) {
+            bool fits = true;
+            for(int number : numbers_on[cell]) {
+                --open[number];
+                placed[number] += value;
+                if(placed[number] > component.needed[number] ||
+                   placed[number] + open[number] < component.needed[number])
+                    fits = false;
+            }
+            if(fits) {
+                choice[cell] = char(value);
+                self(self, cell + 1, mines + value);
+            }
+            for(int number : numbers_on[cell]) {
+                ++open[number];
+                placed[number] -= value;
+            }
+        }
+        choice[cell] = 0;
+    };
+    search(search, 0, 0);
+
+    if(!result.complete) {
+        result.layouts.clear();
+        result.cell_mines.clear();
+        return result;
+    }
+    // most components only ever hold a few mouthbreathers, don't keep a row for every count they can't have
+    while(result.layouts.size() > 1 && result.layouts.back() == 0) {
+        result.layouts.pop_back();
+        result.cell_mines.pop_back();
+    }
+    return result;
+}
+
+mouthbreather::Solver::Solver(Grid& grid)
+    : _grid(grid)
+{
+    std::int64_t cells = std::int64_t(grid.planes().playable.words().size() - 1) * 64;
+    _mines = Bit_Plane(cells);
+    _safe = Bit_Plane(cells);
+    _queued = Bit_Plane(cells);
+}
+
+// start over from the whole room, for the first update or when the grid forgot changes we never read
+void mouthbreather::Solver::rescan()
+{
+    const Bit_Board& planes = _grid.planes();
+    _work.clear();
+    _queued = Bit_Plane(std::int64_t(planes.playable.words().size() - 1) * 64);
+    _frontier.clear();
+    _probabilities_current = false;
+    _safe.and_not(planes.revealed);
+    _safe_queue.clear();
+    const std::vector<std::uint64_t>& safe = _safe.words();
+    for(std::size_t word = 0; word < safe.size(); ++word) {
+        for(std::uint64_t bits = safe[word]; bits; bits &= bits - 1)
+            _safe_queue.push_back(std::int64_t(word) * 64 + std::countr_zero(bits));
+    }
+    const std::vector<std::uint64_t>& playable = planes.playable.words();
+    const std::vector<std::uint64_t>& open = planes.revealed.words();
+    for(std::size_t word = 0; word < playable.size(); ++word) {
+        for(std::uint64_t bits = playable[word] & open[word]; bits; bits &= bits - 1)
+            revealed(std::int64_t(word) * 64 + std::countr_zero(bits));
+    }
+    _position = _grid.change_position();
+}
+
+// a cell showed up in the change log, if it's been revealed the numbers around it and its own number need a look
+void mouthbreather::Solver::revealed(std::int64_t index)
+{
+    const Bit_Board& planes = _grid.planes();
+    if(!planes.playable.test(index) || !planes.revealed.test(index))
+        return;
+    _safe.reset(index);
+    _frontier.erase(index);
+    _probabilities_current = false;
+    int number = _grid.number_at(index);
+    if(number < 0)
+        return;
+    enqueue_numbers_around(index);
+    if(number == 0)
+        return;
+    if(_queued.claim(index))
+        _work.push_back(index);
+    _grid.for_each_neighbor(index, [&](std::int64_t neighbor) {
+        if(!planes.revealed.test(neighbor) && !_mines.test(neighbor) && !_safe.test(neighbor))
+            _frontier.insert(neighbor);
+    });
+}
+
+void mouthbreather::Solver::enqueue_numbers_around(std::int64_t index)
+{
+    _grid.for_each_neighbor(index, [&](std::int64_t neighbor) {
+        if(_grid.number_at(neighbor) > 0 && _queued.claim(neighbor))
+            _work.push_back(neighbor);
+    });
+}
+
+void mouthbreather::Solver::mark_safe(std::int64_t index)
+{
+    if(_safe.test(index) || _mines.test(index) || _grid.planes().revealed.test(index))
+        return;
+    _safe.set(index);
+    _probabilities_current = false;
+    _safe_queue.push_back(index);
+    _frontier.erase(index);
+    enqueue_numbers_around(index);
+}
+
+void mouthbreather::Solver::mark_mine(std::int64_t index)
+{
+    if(_safe.test(index) || _mines.test(index) || _grid.planes().revealed.test(index))
+        return;
+    _mines.set(index);
+    _probabilities_current = false;
+    _frontier.erase(index);
+    enqueue_numbers_around(index);
+}
+
+// the hidden cells around a number that haven't been proven either way, and how many mouthbreathers are among them
+int mouthbreather::Solver::unknowns(std::int64_t number, std::int64_t* cells, int& needed)
+{
+    const Bit_Plane& open = _grid.planes().revealed;
+    int count = 0;
+    needed = _grid.number_at(number);
+    _grid.for_each_neighbor(number, [&](std::int64_t neighbor) {
+        if(open.test(neighbor))
+            return;
+        if(_mines.test(neighbor))
+            --needed;
+        else if(!_safe.test(neighbor))
+            cells[count++] = neighbor;
+    });
+    return count;
+}
+
+// compare a number with every number close enough to share cells with it
+// if one's unknown cells are all inside the other's, the cells only the bigger one has hold the difference between
+// them, which settles those cells when the difference is none of them or all of them
+bool mouthbreather::Solver::subset_rule(std::int64_t number, std::int64_t* cells, int count, int needed)
+{
+    Coordinates here = _grid.coordinates_of(number);
+    Coordinates size = _grid.room_size();
+    auto contains = [](std::int64_t* list, int length, std::int64_t cell) {
+        return std::find(list, list + length, cell) != list + length;
+    };
+    // mark the cells of bigger that aren't in smaller, if that's decided
+    auto settle = [&](std::int64_t* bigger, int bigger_count, int bigger_needed, std::int64_t* smaller,
+                      int smaller_count, int smaller_needed) {
+        int rest = bigger_needed - smaller_needed;
+        int extra = bigger_count - smaller_count;
+        if(rest != 0 && rest != extra)
+            return false;
+        for(int cell = 0; cell < bigger_count; ++cell) {
+            if(contains(smaller, smaller_count, bigger[cell]))
+                continue;
+            if(rest == 0)
+                mark_safe(bigger[cell]);
+            else
+                mark_mine(bigger[cell]);
+        }
+        return true;
+    };
+
+    for(int y = std::max(here.y - 2, 1); y <= std::min(here.y + 2, size.y); ++y) {
+        for(int x = std::max(here.x - 2, 1); x <= std::min(here.x + 2, size.x); ++x) {
+            Coordinates location(x, y);
+            std::int64_t other = _grid.index_of(location);
+            if(other == number || _grid.number_at(other) <= 0)
+                continue;
+            std::int64_t other_cells[8];
+            int other_needed = 0;
+            int other_count = unknowns(other, other_cells, other_needed);
+            if(other_count == 0 || other_count == count)
+                continue;
+            int shared = 0;
+            for(int cell = 0; cell < count; ++cell)
+                shared += contains(other_cells, other_count, cells[cell]);
+            bool settled = false;
+            if(shared == count)
+                settled = settle(other_cells, other_count, other_needed, cells, count, needed);
+            else if(shared == other_count)
+                settled = settle(cells, count, needed, other_cells, other_count, other_needed);
+            if(settled) {
+                if(_queued.claim(number))
+                    _work.push_back(number);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// keep applying the single cell and subset rules to numbers that changed until nothing else changes
+void mouthbreather::Solver::deduce()
+{
+    while(!_work.empty()) {
+        std::int64_t number = _work.back();
+        _work.pop_back();
+        _queued.reset(number);
+        std::int64_t cells[8];
+        int needed = 0;
+        int count = unknowns(number, cells, needed);
+        if(count == 0)
+            continue;
+        if(needed <= 0) {
+            for(int cell = 0; cell < count; ++cell)
+                mark_safe(cells[cell]);
+        } else if(needed >= count) {
+            for(int cell = 0; cell < count; ++cell)
+                mark_mine(cells[cell]);
+        } else
+            subset_rule(number, cells, count, needed);
+    }
+}
+
+// read whatever has changed on the grid since last time and deduce everything the rules can
+void mouthbreather::Solver::update()
+{
+    if(_position < 0 || !_grid.changes_kept_since(_position))
+        rescan();
+    else {
+        for(std::int64_t index : _grid.changes_since(_position))
+            revealed(index);
+        _position = _grid.change_position();
+    }
+    deduce();
+}
+
+// a cell that's proven safe and hasn't been selected yet, -1 if nothing is
+std::int64_t mouthbreather::Solver::next_safe()
+{
+    while(true) {
+        while(!_safe_queue.empty()) {
+            // left on the queue until it's actually revealed, in case the caller doesn't take it
+            if(_safe.test(_safe_queue.front()))
+                return _safe_queue.front();
+            _safe_queue.pop_front();
+        }
+        if(_frontier.empty() || !enumerate_frontier())
+            return -1;
+        deduce();
+    }
+}
+
+// the frontier split into independent components, found by walking from cell to number to cell
+std::vector<Frontier_Component> mouthbreather::Solver::components()
+{
+    std::vector<Frontier_Component> result;
+    std::vector<std::int64_t> starts(_frontier.begin(), _frontier.end());
+    std::sort(starts.begin(), starts.end());
+    std::unordered_set<std::int64_t> visited;
+    std::unordered_set<std::int64_t> numbers_seen;
+    std::vector<std::int64_t> stack;
+
+    for(std::int64_t start : starts) {
+        if(!visited.insert(start).second)
+            continue;
+        Frontier_Component piece;
+        stack.push_back(start);
+        while(!stack.empty()) {
+            std::int64_t cell = stack.back();
+            stack.pop_back();
+            piece.cells.push_back(cell);
+            _grid.for_each_neighbor(cell, [&](std::int64_t number) {
+                if(_grid.number_at(number) <= 0 || !numbers_seen.insert(number).second)
+                    return;
+                piece.numbers.push_back(number);
+                _grid.for_each_neighbor(number, [&](std::int64_t next) {
+                    if(_frontier.count(next) && visited.insert(next).second)
+                        stack.push_back(next);
+                });
+            });
+        }
+        std::sort(piece.cells.begin(), piece.cells.end());
+        std::sort(piece.numbers.begin(), piece.numbers.end());
+        for(std::int64_t number : piece.numbers) {
+            int needed = _grid.number_at(number);
+            std::vector<int> touching;
+            _grid.for_each_neighbor(number, [&](std::int64_t neighbor) {
+                if(_mines.test(neighbor))
+                    --needed;
+                else if(_frontier.count(neighbor))
+                    touching.push_back(
+                        int(std::lower_bound(piece.cells.begin(), piece.cells.end(), neighbor) - piece.cells.begin()));
+            });
+            piece.needed.push_back(needed);
+            piece.touching.push_back(std::move(touching));
+        }
+        result.push_back(std::move(piece));
+    }
+    return result;
+}
+
+// the same cells with the same numbers needing the same counts hash the same
+std::size_t mouthbreather::Component_Key_Hash::operator()(const Component_Key& key) const
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    auto mix = [&](std::uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2);
+    };
+    for(std::int64_t cell : key.cells)
+        mix(std::uint64_t(cell));
+    mix(key.cells.size());
+    for(std::size_t number = 0; number < key.numbers.size(); ++number) {
+        mix(std::uint64_t(key.numbers[number]));
+        mix(std::uint64_t(key.needed[number]));
+    }
+    return std::size_t(hash);
+}
+
+// the layouts of each component, from the cache when a component hasn't changed since last time
+// the ones that did change are enumerated on up to _threads threads, since no component depends on any other
+std::vector<const Component_Layouts*> mouthbreather::Solver::layouts_for(const std::vector<Frontier_Component>& pieces)
+{
+    std::unordered_map<Component_Key, Component_Layouts, Component_Key_Hash> kept;
+    std::vector<Component_Key> keys;
+    std::vector<std::size_t> missing;
+    for(std::size_t piece = 0; piece < pieces.size(); ++piece) {
+        keys.push_back(Component_Key{ pieces[piece].cells, pieces[piece].numbers, pieces[piece].needed });
+        auto found = _layouts.find(keys.back());
+        if(found != _layouts.end())
+            kept.emplace(keys.back(), std::move(found->second));
+        else
+            missing.push_back(piece);
+    }
+
+    std::vector<Component_Layouts> fresh(missing.size());
+    std::atomic<std::size_t> next_piece = 0;
+    auto work = [&]() {
+        for(std::size_t job = next_piece++; job < missing.size(); job = next_piece++)
+            fresh[job] = enumerate_layouts(pieces[missing[job]]);
+    };
+    std::vector<std::thread> workers;
+    for(unsigned id = 1; id < std::min<std::size_t>(_threads, missing.size()); ++id)
+        workers.emplace_back(work);
+    work();
+    for(std::thread& worker : workers)
+        worker.join();
+    for(std::size_t job = 0; job < missing.size(); ++job)
+        kept.emplace(keys[missing[job]], std::move(fresh[job]));
+    _layouts = std::move(kept);
+
+    std::vector<const Component_Layouts*> result;
+    for(const Component_Key& key : keys)
+        result.push_back(&_layouts.at(key));
+    return result;
+}
+
+// enumerate every component of the frontier that changed since the last time, reusing the rest
+// a cell that's a mouthbreather in none of a component's layouts is safe, in all of them it's a mouthbreather
+// true if that proved anything
+bool mouthbreather::Solver::enumerate_frontier()
+{
+    std::vector<Frontier_Component> pieces = components();
+    std::vector<const Component_Layouts*> layouts = layouts_for(pieces);
+    bool progress = false;
+    for(std::size_t piece = 0; piece < pieces.size(); ++piece) {
+        const Component_Layouts& found = *layouts[piece];
+        if(!found.complete)
+            continue;
+        double total = 0;
+        for(double count : found.layouts)
+            total += count;
+        for(std::size_t cell = 0; total > 0 && cell < pieces[piece].cells.size(); ++cell) {
+            double mines = 0;
+            for(const std::vector<double>& row : found.cell_mines)
+                mines += row[cell];
+            if(mines == 0) {
+                mark_safe(pieces[piece].cells[cell]);
+                progress = true;
+            } else if(mines == total) {
+                mark_mine(pieces[piece].cells[cell]);
+                progress = true;
+            }
+        }
+    }
+    return progress;
+}
+
+namespace
+{
+// how much each number of mouthbreathers is worth, weight[i] is for low + i of them
+// only ever relative to each other, the biggest one is kept at 1 so long products don't overflow
+struct Mine_Weights {
+    std::int64_t low = 0;
+    std::vector<double> weight;
+
+    std::int64_t high() const { return low + std::int64_t(weight.size()) - 1; }
+    double at(std::int64_t mines) const
+    {
+        return mines < low || mines > high() ? 0.0 : weight[std::size_t(mines - low)];
+    }
+};
+
+// scale so the biggest weight is 1, and if trim is set drop the negligible counts off both ends
+void rescale(Mine_Weights& weights, bool trim)
+{
+    double biggest = 0;
+    for(double weight : weights.weight)
+        biggest = std::max(biggest, weight);
+    if(biggest == 0)
+        return;
+    for(double& weight : weights.weight)
+        weight /= biggest;
+    if(!trim)
+        return;
+    std::size_t first = 0;
+    std::size_t last = weights.weight.size();
+    while(weights.weight[first] < NEGLIGIBLE_WEIGHT_)
+        ++first;
+    while(weights.weight[last - 1] < NEGLIGIBLE_WEIGHT_)
+        --last;
+    weights.weight.erase(weights.weight.begin() + std::ptrdiff_t(last), weights.weight.end());
+    weights.weight.erase(weights.weight.begin(), weights.weight.begin() + std::ptrdiff_t(first));
+    weights.low += std::int64_t(first);
+}
+
+// weights of the total mouthbreathers in two independent sets of components
+Mine_Weights combine(const Mine_Weights& first, const Mine_Weights& second)
+{
+    Mine_Weights result;
+    result.low = first.low + second.low;
+    result.weight.assign(first.weight.size() + second.weight.size() - 1, 0);
+    for(std::size_t i = 0; i < first.weight.size(); ++i) {
+        if(first.weight[i] == 0)
+            continue;
+        for(std::size_t j = 0; j < second.weight.size(); ++j)
+            result.weight[i + j] += first.weight[i] * second.weight[j];
+    }
+    rescale(result, true);
+    return result;
+}
+
+// outer says how much each total is worth, this says how much each count of mine's is worth once other is added on
+// result[a] = sum over b of other[b] * outer[a + b], for every count mine can have
+Mine_Weights split_off(const Mine_Weights& outer, const Mine_Weights& other, const Mine_Weights& mine)
+{
+    Mine_Weights result;
+    result.low = mine.low;
+    result.weight.assign(mine.weight.size(), 0);
+    for(std::size_t a = 0; a < mine.weight.size(); ++a) {
+        for(std::size_t b = 0; b < other.weight.size(); ++b)
+            result.weight[a] += other.weight[b] * outer.at(mine.low + std::int64_t(a) + other.low + std::int64_t(b));
+    }
+    rescale(result, false);
+    return result;
+}
+
+// products[node] is the combined weights of components [begin, end), children of node are 2 node + 1 and 2 node + 2
+void combine_all(const std::vector<Mine_Weights>& each, std::size_t begin, std::size_t end, std::size_t node,
+                 std::vector<Mine_Weights>& products)
+{
+    if(end - begin == 1) {
+        products[node] = each[begin];
+        return;
+    }
+    std::size_t middle = begin + (end - begin) / 2;
+    combine_all(each, begin, middle, 2 * node + 1, products);
+    combine_all(each, middle, end, 2 * node + 2, products);
+    products[node] = combine(products[2 * node + 1], products[2 * node + 2]);
+}
+
+// walk back down the same tree, so each component ends up with what its own counts are worth given everything else
+// that's the product of all the other components without ever dividing one back out
+void split_all(const std::vector<Mine_Weights>& products, std::size_t begin, std::size_t end, std::size_t node,
+               const Mine_Weights& outer, std::vector<Mine_Weights>& each)
+{
+    if(end - begin == 1) {
+        each[begin] = outer;
+        return;
+    }
+    std::size_t middle = begin + (end - begin) / 2;
+    const Mine_Weights& left = products[2 * node + 1];
+    const Mine_Weights& right = products[2 * node + 2];
+    split_all(products, begin, middle, 2 * node + 1, split_off(outer, right, left), each);
+    split_all(products, middle, end, 2 * node + 2, split_off(outer, left, right), each);
+}
+
+// log of the number of ways to pick chosen cells out of cells
+double log_choose(std::int64_t cells, std::int64_t chosen)
+{
+    if(chosen < 0 || chosen > cells)
+        return -std::numeric_limits<double>::infinity();
+    return std::lgamma(double(cells) + 1) - std::lgamma(double(chosen) + 1) - std::lgamma(double(cells - chosen) + 1);
+}
+} // namespace
+
+// each complete component's layouts grouped by how many mouthbreathers they use, all the components combined into
+// one weight per total, and each total weighted by the ways the rest of the mouthbreathers fit in the cells nobody
+// knows anything about
+// everything's tilted by ratio^mines first, a guess at how fast that last weight falls off, so the weights that
+// matter stay close to each other and the negligible ones can be dropped without changing the answer
+// the components are combined in a tree, so walking back down it gives each one the weight of all the others
+const Mine_Probabilities& mouthbreather::Solver::probabilities()
+{
+    if(_probabilities_current)
+        return _probabilities;
+    _probabilities = Mine_Probabilities();
+    std::vector<Frontier_Component> pieces = components();
+    std::vector<const Component_Layouts*> layouts = layouts_for(pieces);
+
+    const Bit_Board& planes = _grid.planes();
+    Bit_Plane unknown = planes.playable;
+    unknown.and_not(planes.revealed);
+    unknown.and_not(_mines);
+    unknown.and_not(_safe);
+    std::int64_t remaining = _grid.number_of_mouthbreathers() - _mines.count();
+    std::int64_t hidden = unknown.count();
+    std::int64_t unconstrained = hidden;
+    std::vector<std::size_t> complete;
+    for(std::size_t piece = 0; piece < pieces.size(); ++piece) {
+        if(layouts[piece]->complete && !layouts[piece]->layouts.empty()) {
+            complete.push_back(piece);
+            unconstrained -= std::int64_t(pieces[piece].cells.size());
+        } else
+            _probabilities.exact = false;
+    }
+    double density = hidden > 0 ? double(remaining) / double(hidden) : 0;
+    double log_ratio = density > 0 && density < 1 ? std::log(density) - std::log1p(-density) : 0;
+
+    std::vector<Mine_Weights> each(complete.size());
+    for(std::size_t c = 0; c < complete.size(); ++c) {
+        const std::vector<double>& counts = layouts[complete[c]]->layouts;
+        std::vector<double> logs(counts.size());
+        double biggest = -std::numeric_limits<double>::infinity();
+        for(std::size_t k = 0; k < counts.size(); ++k) {
+            logs[k] = counts[k] > 0 ? std::log(counts[k]) + double(k) * log_ratio
+                                    : -std::numeric_limits<double>::infinity();
+            biggest = std::max(biggest, logs[k]);
+        }
+        for(double value : logs)
+            each[c].weight.push_back(std::exp(value - biggest));
+        rescale(each[c], true);
+    }
+    std::vector<Mine_Weights> products(std::max<std::size_t>(4 * complete.size(), 1));
+    if(complete.empty())
+        products[0].weight.push_back(1);
+    else
+        combine_all(each, 0, complete.size(), 0, products);
+
+    // ways to put the rest in the unconstrained cells, over ratio^total to undo the tilt
+    Mine_Weights outer = products[0];
+    for(std::int64_t total = outer.low; total <= outer.high(); ++total)
+        outer.weight[std::size_t(total - outer.low)] =
+            log_choose(unconstrained, remaining - total) - double(total) * log_ratio;
+    double biggest = *std::max_element(outer.weight.begin(), outer.weight.end());
+    if(biggest == -std::numeric_limits<double>::infinity()) {
+        // no total fits the mouthbreathers left, only happens when some cells were guessed at, so forget the count
+        _probabilities.exact = false;
+        std::fill(outer.weight.begin(), outer.weight.end(), 1.0);
+    } else {
+        for(double& weight : outer.weight)
+            weight = std::exp(weight - biggest);
+    }
+
+    double ways = 0;
+    double left_over = 0;
+    for(std::int64_t total = products[0].low; total <= products[0].high(); ++total) {
+        double weight = products[0].at(total) * outer.at(total);
+        ways += weight;
+        left_over += weight * double(remaining - total);
+    }
+    _probabilities.unconstrained = unconstrained;
+    if(unconstrained > 0 && ways > 0)
+        _probabilities.elsewhere = std::clamp(left_over / ways / double(unconstrained), 0.0, 1.0);
+
+    std::vector<Mine_Weights> rest(complete.size());
+    if(!complete.empty())
+        split_all(products, 0, complete.size(), 0, outer, rest);
+    for(std::size_t c = 0; c < complete.size(); ++c) {
+        const Frontier_Component& piece = pieces[complete[c]];
+        const Component_Layouts& found = *layouts[complete[c]];
+        // what a count's layouts are worth on their own, times what that count leaves the rest of the room
+        std::vector<double> worth(found.layouts.size(), 0);
+        double piece_ways = 0;
+        for(std::size_t k = 0; k < found.layouts.size(); ++k) {
+            worth[k] = each[c].at(std::int64_t(k)) * rest[c].at(std::int64_t(k));
+            piece_ways += worth[k];
+        }
+        for(std::size_t cell = 0; cell < piece.cells.size(); ++cell) {
+            double mines = 0;
+            for(std::size_t k = 0; k < found.layouts.size(); ++k) {
+                if(worth[k] > 0)
+                    mines += worth[k] * found.cell_mines[k][cell] / found.layouts[k];
+            }
+            _probabilities.frontier[piece.cells[cell]] = piece_ways > 0 ? mines / piece_ways : 0;
+        }
+    }
+    // too big to enumerate, so all anyone knows is that they're hidden
+    for(std::size_t piece = 0; piece < pieces.size(); ++piece) {
+        if(std::find(complete.begin(), complete.end(), piece) == complete.end()) {
+            for(std::int64_t cell : pieces[piece].cells)
+                _probabilities.frontier[cell] = _probabilities.elsewhere;
+        }
+    }
+    _probabilities_current = true;
+    return _probabilities;
+}
+
+// same thing for one cell, 0 for a revealed or proven safe cell and 1 for a proven mouthbreather
+double mouthbreather::Solver::probability(std::int64_t index)
+{
+    if(_mines.test(index))
+        return 1;
+    if(_safe.test(index) || _grid.planes().revealed.test(index))
+        return 0;
+    const Mine_Probabilities& found = probabilities();
+    auto cell = found.frontier.find(index);
+    return cell != found.frontier.end() ? cell->second : found.elsewhere;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include "mouthbreather.hpp"
+#include <deque>
+#include <unordered_set>
+
+namespace mouthbreather
+{
+// most cells a frontier component can have before enumerating it isn't worth trying
+constexpr std::size_t COMPONENT_CELL_LIMIT_ = 256;
+// most steps the search takes on one component before giving up on it
+constexpr std::int64_t ENUMERATION_STEP_LIMIT_ = 1 << 22;
+// mine counts weighted less than this next to the likeliest count are dropped when components are combined
+constexpr double NEGLIGIBLE_WEIGHT_ = 1e-200;
+
+// a connected piece of the frontier: hidden cells nobody has proven anything about, plus the revealed numbers that
+// touch them, where none of those numbers touch a hidden cell in any other component
+struct Frontier_Component {
+    std::vector<std::int64_t> cells;        // grid indices, sorted
+    std::vector<std::int64_t> numbers;      // grid indices of the revealed numbers, sorted
+    std::vector<int> needed;                // how many mouthbreathers each number still needs among cells
+    std::vector<std::vector<int>> touching; // for each number, which of cells (positions in cells) it touches
+};
+
+// everything a component's layouts depend on, touching follows from cells and numbers
+// the layout cache is keyed on this rather than a hash of it, so two components that happen to hash the same never
+// get each other's layouts
+struct Component_Key {
+    std::vector<std::int64_t> cells;
+    std::vector<std::int64_t> numbers;
+    std::vector<int> needed;
+
+    bool operator==(const Component_Key& other) const = default;
+};
+
+struct Component_Key_Hash {
+    std::size_t operator()(const Component_Key& key) const;
+};
+
+// every way the mouthbreathers could be laid out over a component, grouped by how many of them there are
+struct Component_Layouts {
+    std::vector<double> layouts;                 // layouts[k], how many layouts have exactly k mouthbreathers
+    std::vector<std::vector<double>> cell_mines; // cell_mines[k][i], how many of those put one on cells[i]
+    bool complete = true;                        // false if the component was too big or the search ran out of steps
+};
+
+// try every layout of a component that agrees with all of its numbers
+Component_Layouts enumerate_layouts(const Frontier_Component& component);
+
+// the chance of a mouthbreather under every hidden cell nobody has proven anything about
+// every layout of the frontier that fits the numbers counts, weighted by how many ways the mouthbreathers it leaves
+// over could be spread across the rest of the room
+struct Mine_Probabilities {
+    std::unordered_map<std::int64_t, double> frontier; // hidden cells touching a number
+    double elsewhere = 0;           // any other hidden cell, they all have the same chance
+    std::int64_t unconstrained = 0; // how many cells that is
+    bool exact = true; // false if a component was too big to enumerate, its cells are counted as elsewhere
+};
+
+// works out which hidden cells are safe and which are mouthbreathers from what's been revealed, and nothing else
+// keeps up with the Grid through its change log, so after a select it only looks again at numbers around the cells
+// that changed instead of the whole room
+class Solver
+{
+    Grid& _grid;
+    std::int64_t _position = -1; // how far through the grid's change log we've read, -1 before the first update
+    Bit_Plane _mines;            // cells proven to be mouthbreathers
+    Bit_Plane _safe;             // cells proven safe that haven't been revealed yet
+    std::deque<std::int64_t> _safe_queue;
+    std::vector<std::int64_t> _work; // revealed numbers that need another look
+    Bit_Plane _queued;               // which cells are in _work
+    std::unordered_set<std::int64_t> _frontier; // hidden cells touching a number that haven't been proven either way
+    // enumerations of components that haven't changed, so a move only costs the ones it touched
+    std::unordered_map<Component_Key, Component_Layouts, Component_Key_Hash> _layouts;
+    unsigned _threads = 1;
+    Mine_Probabilities _probabilities;
+    bool _probabilities_current = false; // nothing's been proven or revealed since _probabilities was worked out
+
+    void rescan();
+    void revealed(std::int64_t index);
+    void enqueue_numbers_around(std::int64_t index);
+    void mark_safe(std::int64_t index);
+    void mark_mine(std::int64_t index);
+    int unknowns(std::int64_t number, std::int64_t* cells, int& needed);
+    bool subset_rule(std::int64_t number, std::int64_t* cells, int count, int needed);
+    void deduce();
+    std::vector<const Component_Layouts*> layouts_for(const std::vector<Frontier_Component>& pieces);
+    bool enumerate_frontier();
+
+public:
+    Solver(Grid& grid);
+
+    // read whatever has changed on the grid since last time and deduce everything the rules can
+    void update();
+    // a cell that's proven safe and hasn't been selected yet, -1 if nothing is
+    // falls back to enumerating the frontier once the single cell and subset rules have nothing left
+    std::int64_t next_safe();
+    bool proven_mine(std::int64_t index) { return _mines.test(index); }
+    const Bit_Plane& mines() { return _mines; }
+    bool proven_safe(std::int64_t index) { return _safe.test(index); }
+    std::int64_t mines_found() { return _mines.count(); }
+    // the frontier split into independent components, each one sorted so the same component always looks the same
+    std::vector<Frontier_Component> components();
+    // the chance of a mouthbreather under each hidden cell, worked out again only after something changed and only
+    // enumerating components that changed
+    const Mine_Probabilities& probabilities();
+    // same thing for one cell, 0 for a revealed or proven safe cell and 1 for a proven mouthbreather
+    double probability(std::int64_t index);
+    // enumerate components that changed on up to this many threads at once, 1 keeps it single threaded
+    void set_threads(unsigned threads) { _threads = threads > 0 ? threads : 1; }
+};
+} // namespace mouthbreather